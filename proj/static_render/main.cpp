@@ -2,18 +2,43 @@
 #include "function/render/render_engine.h"
 #include "physics.h"
 #include "ui.h"
+#include <iostream>
 
-int main()
+int main(int argc, char** argv)
 {
+    std::string config_path = "./config/config.json";
+    std::string batch_path;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--config" && i + 1 < argc) {
+            config_path = argv[++i];
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batch_path = argv[++i];
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--config config.json] [--batch batch.json]" << std::endl;
+            return 1;
+        }
+    }
+
     RenderEngine render_engine;
     UIEngineUser ui_engine;
     PhysicsEngineUser physics_engine;
 
-    Configuration config = Configuration::load("./config/config.json");
+    Configuration config = Configuration::load(config_path);
+    // batches render as fast as possible: no window, no vsync, no UI, and
+    // the recorder is driven by the runs and keeps every frame
+    if (!batch_path.empty()) {
+        config.headless.enabled = true;
+        config.recorder.record_from_start = false;
+        config.recorder.overflow = "block";
+    }
 
     Engine engine;
     engine.init(config, &render_engine, &ui_engine, &physics_engine);
-    engine.run();
+    if (batch_path.empty())
+        engine.run();
+    else
+        engine.runBatch(BatchConfiguration::load(batch_path));
     engine.cleanup();
 
     return 0;
@@ -53,9 +53,22 @@ __global__ void fill(cudaSurfaceObject_t surface_object, cudaExtent extent, size
     }
 }
 
+// the second buffer of a double buffered field, see Fields::solverBuffer
+static std::string extImageName(const std::string& field_name, uint32_t buffer)
+{
+    return buffer == 0 ? field_name : field_name + "_back";
+}
+
 void PhysicsEngineUser::init(Configuration& config, GlobalContext* g_ctx)
 {
     CudaEngine::init(config, g_ctx);
+
+    if (g_ctx->rm->fields.has_temperature) {
+        g_ctx->rm->fields.lights_updater->benchmark(
+            extImages["fire_field"].surface_object,
+            streamToRun,
+            config.fields.fire_configuration.light_sample_benchmark_iterations);
+    }
 }
 
 void PhysicsEngineUser::initExternalMem()
@@ -81,42 +94,48 @@ void PhysicsEngineUser::initExternalMem()
     //         this->importExtBuffer(buffer_desc); // add to extBuffers internally
     //     }
 
-    for (int i = 0; i < g_ctx->rm->fields.fields.size(); i++) {
-        auto& field = g_ctx->rm->fields.fields[i];
+    auto& fields = g_ctx->rm->fields;
+    for (int i = 0; i < fields.fields.size(); i++) {
+        auto& field = fields.fields[i];
+        for (uint32_t buffer = 0; buffer < (fields.double_buffered ? 2 : 1); buffer++) {
 #ifdef _WIN64
-        HANDLE handle = shared_data.fields.getVkFieldMemHandle(i);
+            HANDLE handle = fields.getVkFieldMemHandle(i, buffer);
 #else
-        int fd = g_ctx->rm->fields.getVkFieldMemHandle(i);
+            int fd = fields.getVkFieldMemHandle(i, buffer);
 #endif
-        CudaEngine::ExtImageDesc image_desc = {
+            const auto& extent = field.image(buffer).extent;
+            CudaEngine::ExtImageDesc image_desc = {
 #ifdef _WIN64
-            handle,
+                handle,
 #else
-            fd,
+                fd,
 #endif
-            128 * 256 * 128 * sizeof(float),
-            sizeof(float),
-            128,
-            256,
-            128,
-            field.name
-        };
-        this->importExtImage(image_desc); // add to extBuffers internally
+                extent.width * extent.height * extent.depth * sizeof(float),
+                sizeof(float),
+                extent.width,
+                extent.height,
+                extent.depth,
+                extImageName(field.name, buffer)
+            };
+            this->importExtImage(image_desc); // add to extBuffers internally
+        }
     }
 }
 
 void PhysicsEngineUser::step()
 {
-    waitOnSemaphore(vkUpdateSemaphore);
+    waitOnSemaphore(vkUpdateSemaphore, renderedFrameValue());
 
     if (g_ctx->rm->fields.has_temperature) {
+        // sample the buffer the next frame renders
+        uint32_t buffer = g_ctx->rm->fields.solverBuffer(g_ctx->currentFrame);
         g_ctx->rm->fields.lights_updater->updateFireLightData(
-            extImages["fire_field"].surface_object,
+            extImages[extImageName("fire_field", buffer)].surface_object,
             streamToRun,
             g_ctx->rm->fields.lights);
     }
 
-    signalSemaphore(cuUpdateSemaphore);
+    signalSemaphore(cuUpdateSemaphore, steppedFrameValue());
 }
 
 void PhysicsEngineUser::cleanup()
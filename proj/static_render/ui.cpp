@@ -1,6 +1,7 @@
 #include "ui.h"
 #include "core/config/config.h"
 #include "core/tool/logger.h"
+#include "core/tool/tracer.h"
 #include "function/global_context.h"
 #include "function/resource_manager/resource_manager.h"
 #include "imgui_impl_glfw.h"
@@ -88,6 +89,26 @@ void UIEngineUser::recordingUI()
     ImGui::End();
 }
 
+void UIEngineUser::profilerUI()
+{
+    const auto& profiler = g_ctx.gpu_profiler;
+    ImGui::Begin("Profiler");
+    if (tracer.enabled() && ImGui::Button("Dump CPU Trace")) {
+        tracer.dump();
+    }
+    if (!profiler.enabled()) {
+        ImGui::Text("timestamps not supported");
+        ImGui::End();
+        return;
+    }
+    ImGui::Text("frame %.3f ms", profiler.frameMs());
+    ImGui::Text("field step scale %.2f", g_ctx.rm->fields.step_scale);
+    for (const auto& timing : profiler.timings()) {
+        ImGui::Text("%-20s %.3f ms", timing.name.c_str(), timing.average_ms);
+    }
+    ImGui::End();
+}
+
 std::function<void(VkCommandBuffer)> UIEngineUser::getDrawUIFunction()
 {
     return [](VkCommandBuffer commandBuffer) {
@@ -154,6 +175,7 @@ std::function<void(VkCommandBuffer)> UIEngineUser::getDrawUIFunction()
         ImGui::End();
 
         recordingUI();
+        profilerUI();
 
         drawAxis();
 
@@ -8,6 +8,7 @@ class UIEngineUser : public ImGuiEngine {
     void handleMouseInput() ;
     void handleKeyboardInput() ;
     static void recordingUI();
+    static void profilerUI();
 
     ImVec2 prev_mouse_delta;
     static std::string record_output_path;
@@ -1,6 +1,7 @@
 #include "config.h"
 #include <fstream>
 #include <nlohmann/json.hpp>
+#include <stdexcept>
 
 using json = nlohmann::json;
 
@@ -85,7 +86,10 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
     light_sample_gain,
     self_illumination_lights,
     self_illumination_boost,
-    fire_colors_path);
+    fire_colors_path,
+    light_sample_benchmark_iterations,
+    light_update_interval,
+    light_smoothing);
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
     FieldsConfiguration,
@@ -131,14 +135,55 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
     LoggerConfiguration,
     level,
-    output);
+    output,
+    async,
+    queue_size);
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
+    ImageExportConfiguration,
+    enabled,
+    format,
+    threads,
+    queue_frames,
+    transmittance);
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
     RecorderConfiguration,
     output_path,
     bit_rate,
     frame_rate,
-    record_from_start);
+    record_from_start,
+    preset,
+    encoder_threads,
+    queue_frames,
+    overflow,
+    gpu_yuv,
+    image_export);
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
+    FramePipelineConfiguration,
+    depth,
+    double_buffered_fields,
+    frames_in_flight,
+    record_threads);
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
+    HeadlessConfiguration,
+    enabled,
+    frames);
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
+    FieldBudgetConfiguration,
+    enabled,
+    node,
+    target_frame_ms,
+    min_step_scale,
+    max_step_scale);
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
+    TracerConfiguration,
+    enabled,
+    output_path);
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
     Configuration,
@@ -158,7 +203,31 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
     textures,
     rigid_couple,
     driver,
-    recorder);
+    recorder,
+    frame_pipeline,
+    headless,
+    tracer,
+    field_budget);
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
+    CameraKeyframe,
+    time,
+    position,
+    rotation);
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
+    FieldSweepConfiguration,
+    field,
+    parameter,
+    values);
+
+// camera_path and sweep are optional
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE_WITH_DEFAULT(
+    BatchConfiguration,
+    frames,
+    output_path,
+    camera_path,
+    sweep);
 
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
     RigidCoupleSimConfiguration,
@@ -173,6 +242,16 @@ Configuration Configuration::load(const std::string& config_path)
     return config;
 }
 
+BatchConfiguration BatchConfiguration::load(const std::string& config_path)
+{
+    std::ifstream f(config_path);
+    BatchConfiguration config = json::parse(f);
+    if (config.frames == 0 || config.output_path.empty()) {
+        throw std::runtime_error("Batch configuration needs frames and output_path: " + config_path);
+    }
+    return config;
+}
+
 RigidCoupleSimConfiguration RigidCoupleSimConfiguration::load(const std::string& config_path)
 {
     std::ifstream f(config_path);
@@ -59,6 +59,9 @@ struct FireConfiguration {
     float light_sample_gain;
     float self_illumination_boost;
     std::string fire_colors_path;
+    int light_sample_benchmark_iterations;
+    int light_update_interval;
+    float light_smoothing;
 };
 
 struct FieldsConfiguration {
@@ -105,6 +108,21 @@ struct DriverConfiguration {
 struct LoggerConfiguration {
     std::string level;
     std::string output;
+    // write from a background thread, queue_size messages are preallocated
+    bool async;
+    uint32_t queue_size;
+};
+
+// Writes image sequences of the HDR color, depth and optionally the field
+// transmittance instead of a video, format is "tiff" (float) or "png" (16 bit).
+// threads == 0 uses one per hardware thread.
+struct ImageExportConfiguration {
+    bool enabled;
+    std::string format;
+    uint32_t threads;
+    // frames buffered for the writer threads, each one frameSize bytes
+    uint32_t queue_frames;
+    bool transmittance;
 };
 
 struct RecorderConfiguration {
@@ -112,6 +130,48 @@ struct RecorderConfiguration {
     int64_t bit_rate;
     int frame_rate;
     bool record_from_start;
+    // x264 preset
+    std::string preset;
+    // codec threads, 0 picks automatically
+    int encoder_threads;
+    // frames buffered for the encoder thread
+    uint32_t queue_frames;
+    // "block", "drop" or "spill" when the buffered frames are all in use
+    std::string overflow;
+    // convert to YUV420 on the GPU before the readback
+    bool gpu_yuv;
+    // the output path without its extension names the export directory
+    ImageExportConfiguration image_export;
+};
+
+// renders into offscreen images of width x height without a window, for
+// machines without a display. frames == 0 runs until the process is stopped.
+struct HeadlessConfiguration {
+    bool enabled;
+    uint32_t frames;
+};
+
+// Adjusts the ray marching step of node within the scale bounds to keep the
+// GPU frame time at target_frame_ms, interactive runs only.
+struct FieldBudgetConfiguration {
+    bool enabled;
+    std::string node;
+    float target_frame_ms;
+    float min_step_scale;
+    float max_step_scale;
+};
+
+// CPU trace markers, dumped to output_path on demand and at exit
+struct TracerConfiguration {
+    bool enabled;
+    std::string output_path;
+};
+
+struct FramePipelineConfiguration {
+    uint32_t depth;
+    bool double_buffered_fields;
+    uint32_t frames_in_flight;
+    uint32_t record_threads;
 };
 
 struct Configuration {
@@ -140,6 +200,39 @@ struct Configuration {
     DriverConfiguration driver;
 
     RecorderConfiguration recorder;
+    FramePipelineConfiguration frame_pipeline;
+    HeadlessConfiguration headless;
+    TracerConfiguration tracer;
+    FieldBudgetConfiguration field_budget;
+};
+
+struct CameraKeyframe {
+    float time;
+    std::array<float, 3> position;
+    // yaw and pitch in degrees
+    std::array<float, 2> rotation;
+};
+
+// Every value is one run. step is a single float, scatter and absorption
+// three; they apply to the named field or to all fields if it's empty.
+struct FieldSweepConfiguration {
+    std::string field;
+    std::string parameter;
+    std::vector<std::vector<float>> values;
+};
+
+struct BatchConfiguration {
+    static BatchConfiguration load(const std::string& config_path);
+
+    // frames per run, at recorder.frame_rate
+    uint32_t frames = 0;
+    // {} is replaced by the run index. Patterns like frame_%05d.png write
+    // image sequences instead of a video.
+    std::string output_path;
+    // linearly interpolated, the camera stays put when empty
+    std::vector<CameraKeyframe> camera_path;
+    // a single run when left out
+    FieldSweepConfiguration sweep;
 };
 
 struct RigidCoupleSimConfiguration {
@@ -0,0 +1,188 @@
+#include "frame_exporter.h"
+#include "core/config/config.h"
+#include "core/tool/logger.h"
+#include "core/tool/thread_pool.h"
+#include "core/tool/tracer.h"
+#include <algorithm>
+#include <boost/gil.hpp>
+#include <boost/gil/extension/io/png.hpp>
+#include <boost/gil/extension/io/tiff.hpp>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// ACES fit and gamma of HDRToSDR, see common.glsl
+uint16_t toneMapped(float v)
+{
+    v = (v * (2.51f * v + 0.03f)) / (v * (2.43f * v + 0.59f) + 0.14f);
+    v = std::pow(std::max(v, 0.0f), 1.0f / 2.2f);
+    return static_cast<uint16_t>(std::clamp(v, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+uint16_t unorm16(float v)
+{
+    return static_cast<uint16_t>(std::clamp(v, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+template <typename View>
+void writeImage(const std::filesystem::path& path, const View& view, FrameExporter::Format format)
+{
+    using namespace boost::gil;
+    if (format == FrameExporter::Format::Tiff) {
+        image_write_info<tiff_tag> info;
+        info._compression = COMPRESSION_ADOBE_DEFLATE;
+        write_view(path.string(), view, info);
+    } else {
+        write_view(path.string(), view, png_tag {});
+    }
+}
+
+}
+
+FrameExporter::FrameExporter() = default;
+FrameExporter::~FrameExporter() = default;
+
+void FrameExporter::init(const ImageExportConfiguration& config)
+{
+    if (config.format == "tiff") {
+        format = Format::Tiff;
+    } else if (config.format == "png") {
+        format = Format::Png;
+    } else {
+        throw std::runtime_error("Invalid image export format: " + config.format);
+    }
+    transmittance = config.transmittance;
+    thread_count = config.threads;
+    queue_frames = std::max(1u, config.queue_frames);
+}
+
+std::filesystem::path FrameExporter::imagePath(const char* name, uint64_t index) const
+{
+    return directory / fmt::format("{}_{:06}.{}", name, index, format == Format::Tiff ? "tiff" : "png");
+}
+
+void FrameExporter::begin(const std::filesystem::path& directory, uint32_t width, uint32_t height)
+{
+    if (!std::filesystem::exists(directory)) {
+        std::filesystem::create_directories(directory);
+    }
+    this->directory = directory;
+    this->width = width;
+    this->height = height;
+
+    if (!pool)
+        pool = std::make_unique<ThreadPool>(thread_count);
+    // the buffers hold whole HDR frames, so their count is configured rather
+    // than scaled with the worker count
+    frames.resize(queue_frames);
+    free_frames.clear();
+    for (uint32_t i = 0; i < frames.size(); i++) {
+        frames[i].data.resize(frameSize(width, height));
+        frames[i].pending = 0;
+        free_frames.emplace_back(i);
+    }
+    failed = false;
+    next_index = 0;
+    INFO_FILE("exporting frames to {} with {} threads", directory.string(), pool->size());
+}
+
+void FrameExporter::append(const uint8_t* data)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    free_cv.wait(lock, [this]() { return !free_frames.empty() || failed; });
+    if (failed)
+        throw std::runtime_error("Image export failed");
+
+    uint32_t frame = free_frames.back();
+    free_frames.pop_back();
+    frames[frame].index = next_index++;
+    frames[frame].pending = 2;
+    lock.unlock();
+
+    memcpy(frames[frame].data.data(), data, frames[frame].data.size());
+    submit(frame, &FrameExporter::writeColor);
+    submit(frame, &FrameExporter::writeDepth);
+}
+
+void FrameExporter::submit(uint32_t frame, void (FrameExporter::*write)(const Frame&) const)
+{
+    pool->submit([this, frame, write]() {
+        bool ok = true;
+        try {
+            (this->*write)(frames[frame]);
+        } catch (const std::exception& e) {
+            CRITICAL_FILE("Could not export frame {}: {}", frames[frame].index, e.what());
+            ok = false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            failed = failed || !ok;
+            if (--frames[frame].pending == 0)
+                free_frames.emplace_back(frame);
+        }
+        free_cv.notify_all();
+    });
+}
+
+void FrameExporter::writeColor(const Frame& frame) const
+{
+    PROFILE_SCOPE("FrameExporter::writeColor");
+    using namespace boost::gil;
+    const float* color = reinterpret_cast<const float*>(frame.data.data());
+    const size_t pixels = size_t(width) * height;
+    const size_t channels = transmittance ? 4 : 3;
+    auto path = imagePath("color", frame.index);
+
+    if (format == Format::Tiff) {
+        if (transmittance) {
+            writeImage(path, interleaved_view(width, height, reinterpret_cast<const rgba32f_pixel_t*>(color), width * sizeof(rgba32f_pixel_t)), format);
+            return;
+        }
+        std::vector<float> packed(pixels * 3);
+        for (size_t i = 0; i < pixels; i++)
+            std::copy_n(color + i * 4, 3, packed.data() + i * 3);
+        writeImage(path, interleaved_view(width, height, reinterpret_cast<const rgb32f_pixel_t*>(packed.data()), width * sizeof(rgb32f_pixel_t)), format);
+        return;
+    }
+
+    std::vector<uint16_t> packed(pixels * channels);
+    for (size_t i = 0; i < pixels; i++) {
+        for (size_t c = 0; c < 3; c++)
+            packed[i * channels + c] = toneMapped(color[i * 4 + c]);
+        if (transmittance)
+            packed[i * channels + 3] = unorm16(color[i * 4 + 3]);
+    }
+    if (transmittance)
+        writeImage(path, interleaved_view(width, height, reinterpret_cast<const rgba16_pixel_t*>(packed.data()), width * sizeof(rgba16_pixel_t)), format);
+    else
+        writeImage(path, interleaved_view(width, height, reinterpret_cast<const rgb16_pixel_t*>(packed.data()), width * sizeof(rgb16_pixel_t)), format);
+}
+
+void FrameExporter::writeDepth(const Frame& frame) const
+{
+    PROFILE_SCOPE("FrameExporter::writeDepth");
+    using namespace boost::gil;
+    const size_t pixels = size_t(width) * height;
+    const float* depth = reinterpret_cast<const float*>(frame.data.data()) + pixels * 4;
+    auto path = imagePath("depth", frame.index);
+
+    if (format == Format::Tiff) {
+        writeImage(path, interleaved_view(width, height, reinterpret_cast<const gray32f_pixel_t*>(depth), width * sizeof(gray32f_pixel_t)), format);
+        return;
+    }
+    std::vector<uint16_t> packed(pixels);
+    for (size_t i = 0; i < pixels; i++)
+        packed[i] = unorm16(depth[i]);
+    writeImage(path, interleaved_view(width, height, reinterpret_cast<const gray16_pixel_t*>(packed.data()), width * sizeof(gray16_pixel_t)), format);
+}
+
+void FrameExporter::end()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    free_cv.wait(lock, [this]() { return free_frames.size() == frames.size(); });
+    INFO_FILE("exported {} frames", next_index);
+    if (failed)
+        ERROR_ALL("Image export failed, some frames in {} are missing", directory.string());
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ImageExportConfiguration;
+class ThreadPool;
+
+// Writes every frame as a color and a depth image into a directory, named
+// color_<frame> and depth_<frame>. Each image is compressed by its own task on
+// a thread pool, so frames finish out of order. append only blocks while all
+// frame buffers wait for their images to be written.
+class FrameExporter {
+public:
+    enum class Format {
+        // 32 bit float, deflate compressed
+        Tiff,
+        // 16 bit, color tone mapped like HDRToSDR
+        Png,
+    };
+    // width * height R32G32B32A32 color pixels followed by width * height
+    // D32 depth values, row by row. The alpha channel holds the transmittance
+    // through the fields.
+    static size_t frameSize(uint32_t width, uint32_t height) { return size_t(width) * height * 5 * sizeof(float); }
+
+    FrameExporter();
+    ~FrameExporter();
+
+    void init(const ImageExportConfiguration& config);
+    void begin(const std::filesystem::path& directory, uint32_t width, uint32_t height);
+    void append(const uint8_t* data);
+    // waits until every appended frame is written
+    void end();
+
+private:
+    struct Frame {
+        std::vector<uint8_t> data;
+        uint64_t index;
+        // images of the frame not written yet
+        uint32_t pending;
+    };
+    void writeColor(const Frame& frame) const;
+    void writeDepth(const Frame& frame) const;
+    void submit(uint32_t frame, void (FrameExporter::*write)(const Frame&) const);
+    std::filesystem::path imagePath(const char* name, uint64_t index) const;
+
+    Format format = Format::Tiff;
+    bool transmittance = false;
+    uint32_t thread_count = 0;
+    uint32_t queue_frames = 1;
+
+    std::unique_ptr<ThreadPool> pool;
+    std::mutex mutex;
+    // signaled when a frame buffer is free again
+    std::condition_variable free_cv;
+    std::vector<Frame> frames;
+    std::vector<uint32_t> free_frames;
+    bool failed = false;
+
+    std::filesystem::path directory;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint64_t next_index = 0;
+};
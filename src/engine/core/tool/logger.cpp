@@ -1,5 +1,6 @@
 #include "logger.h"
 #include "core/config/config.h"
+#include "spdlog/async.h"
 #include "spdlog/sinks/basic_file_sink.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 #include <filesystem>
@@ -13,8 +14,19 @@ void Logger::init(Configuration& config)
     if (std::filesystem::exists(config.logger.output)) {
         std::filesystem::remove(config.logger.output);
     }
-    file = spdlog::basic_logger_mt("file", config.logger.output);
-    console = spdlog::stdout_color_mt("console");
+    if (config.logger.async) {
+        // Messages are formatted on the calling thread and written by a
+        // single background thread. The queue is preallocated, when it is full
+        // the oldest message is dropped instead of blocking the caller.
+        spdlog::init_thread_pool(config.logger.queue_size, 1);
+        file = spdlog::basic_logger_mt<spdlog::async_factory_nonblock>("file", config.logger.output);
+        console = spdlog::stdout_color_mt<spdlog::async_factory_nonblock>("console");
+        spdlog::flush_every(std::chrono::seconds(1));
+    } else {
+        file = spdlog::basic_logger_mt("file", config.logger.output);
+        console = spdlog::stdout_color_mt("console");
+    }
+    file->flush_on(spdlog::level::warn);
 
     spdlog::set_level(spdlog::level::trace);
     file->set_level(spdlog::level::trace);
@@ -51,3 +63,8 @@ void Logger::init(Configuration& config)
         throw std::runtime_error("Invalid log level: " + config.logger.level);
     }
 }
+
+void Logger::shutdown()
+{
+    spdlog::shutdown();
+}
@@ -1,6 +1,10 @@
 #pragma once
 
+// Calls below the active level compile to nothing, release builds strip the
+// per-frame TRACE_* logs this way (see xmake.lua).
+#ifndef SPDLOG_ACTIVE_LEVEL
 #define SPDLOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
+#endif
 #include <spdlog/spdlog.h>
 
 class Configuration;
@@ -12,6 +16,8 @@ class Logger {
 public:
     Logger() = default;
     void init(Configuration& config);
+    // flushes what the async loggers still have queued
+    void shutdown();
 
     constexpr auto& Console() const
     {
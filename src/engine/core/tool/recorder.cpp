@@ -1,6 +1,9 @@
 #include "recorder.h"
 #include "core/config/config.h"
 #include "core/tool/logger.h"
+#include "core/tool/tracer.h"
+#include <algorithm>
+#include <cstring>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -20,6 +23,25 @@ void Recorder::init(const Configuration& config)
 
     bit_rate = config.recorder.bit_rate;
     frame_rate = config.recorder.frame_rate;
+    preset = config.recorder.preset;
+    encoder_threads = config.recorder.encoder_threads;
+    buffers.resize(std::max(1u, config.recorder.queue_frames));
+    if (config.recorder.overflow == "block") {
+        overflow = Overflow::Block;
+    } else if (config.recorder.overflow == "drop") {
+        overflow = Overflow::Drop;
+    } else if (config.recorder.overflow == "spill") {
+        overflow = Overflow::Spill;
+    } else {
+        throw std::runtime_error("Invalid recorder overflow policy: " + config.recorder.overflow);
+    }
+    exporter.init(config.recorder.image_export);
+    // the graph picks the matching Record node, this only matters for
+    // recordings starting before it is built
+    if (config.recorder.image_export.enabled)
+        input = Input::HDR;
+    else if (config.recorder.gpu_yuv)
+        input = Input::YUV420;
     is_recording = config.recorder.record_from_start;
     if (is_recording) {
         begin(config.recorder.output_path, config.width, config.height);
@@ -63,10 +85,19 @@ void Recorder::begin_ffmpeg(const std::filesystem::path& path, uint32_t width, u
         ost.codec_ctx->framerate = { frame_rate, 1 };
         ost.codec_ctx->gop_size = 10;
         ost.codec_ctx->max_b_frames = 1;
-        ost.codec_ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+        // image encoders like png don't take yuv
+        ost.codec_ctx->pix_fmt = codec->pix_fmts != nullptr ? codec->pix_fmts[0] : AV_PIX_FMT_YUV420P;
+        if (input == Input::YUV420) {
+            ost.codec_ctx->colorspace = AVCOL_SPC_BT709;
+            ost.codec_ctx->color_primaries = AVCOL_PRI_BT709;
+            ost.codec_ctx->color_trc = AVCOL_TRC_BT709;
+            ost.codec_ctx->color_range = AVCOL_RANGE_MPEG;
+        }
+        // 0 lets the codec pick
+        ost.codec_ctx->thread_count = encoder_threads;
 
         if (codec->id == AV_CODEC_ID_H264) {
-            av_opt_set(ost.codec_ctx->priv_data, "preset", "slow", 0);
+            av_opt_set(ost.codec_ctx->priv_data, "preset", preset.c_str(), 0);
         }
         if (ost.codec_ctx->codec_id == AV_CODEC_ID_MPEG2VIDEO) {
             ost.codec_ctx->max_b_frames = 2;
@@ -112,28 +143,33 @@ void Recorder::begin_ffmpeg(const std::filesystem::path& path, uint32_t width, u
             return;
         }
     }
-    ost.rgb_frame = av_frame_alloc();
-    {
-        ost.rgb_frame->format = AV_PIX_FMT_BGRA;
-        ost.rgb_frame->width = ost.codec_ctx->width;
-        ost.rgb_frame->height = ost.codec_ctx->height;
-        ost.rgb_frame->pts = 0;
-        ret = av_frame_get_buffer(ost.rgb_frame, 0);
+    // input the codec takes as is goes straight into ost.frame
+    const AVPixelFormat input_format = input == Input::YUV420 ? AV_PIX_FMT_YUV420P : AV_PIX_FMT_BGRA;
+    ost.input_frame = nullptr;
+    ost.sws_ctx = nullptr;
+    if (input_format != ost.codec_ctx->pix_fmt) {
+        ost.input_frame = av_frame_alloc();
+        ost.input_frame->format = input_format;
+        ost.input_frame->width = ost.codec_ctx->width;
+        ost.input_frame->height = ost.codec_ctx->height;
+        ost.input_frame->pts = 0;
+        ret = av_frame_get_buffer(ost.input_frame, 0);
         if (ret < 0) {
             CRITICAL_FILE("Could not allocate frame buffer, error: {}", av_err2str(ret));
             throw std::runtime_error("Could not allocate frame buffer");
             return;
         }
-        TRACE_FILE("linesize: {}", ost.rgb_frame->linesize[0]);
-        TRACE_FILE("width * 4: {}", ost.rgb_frame->width * 4);
-    }
+        TRACE_FILE("linesize: {}", ost.input_frame->linesize[0]);
 
-    ost.sws_ctx = sws_getContext(
-        ost.codec_ctx->width, ost.codec_ctx->height, AV_PIX_FMT_BGRA,
-        ost.codec_ctx->width, ost.codec_ctx->height, AV_PIX_FMT_YUV420P,
-        SWS_BILINEAR, NULL, NULL, NULL);
+        ost.sws_ctx = sws_getContext(
+            ost.codec_ctx->width, ost.codec_ctx->height, input_format,
+            ost.codec_ctx->width, ost.codec_ctx->height, ost.codec_ctx->pix_fmt,
+            SWS_BILINEAR, NULL, NULL, NULL);
+    }
 
-    ret = avio_open(&fmt_ctx->pb, path.string().c_str(), AVIO_FLAG_WRITE);
+    // image sequence muxers open a file per frame themselves
+    if (!(fmt_ctx->oformat->flags & AVFMT_NOFILE))
+        ret = avio_open(&fmt_ctx->pb, path.string().c_str(), AVIO_FLAG_WRITE);
     if (ret < 0) {
         CRITICAL_FILE("Could not open output file, error: {}", av_err2str(ret));
         throw std::runtime_error("Could not open output file");
@@ -151,6 +187,14 @@ void Recorder::begin_ffmpeg(const std::filesystem::path& path, uint32_t width, u
 
 void Recorder::begin(const std::filesystem::path& path, uint32_t width, uint32_t height)
 {
+    if (input == Input::HDR) {
+        auto directory = path;
+        exporter.begin(directory.replace_extension(), width, height);
+        is_recording = true;
+        INFO_FILE("recording started");
+        return;
+    }
+
     auto folder = path.parent_path();
     if (!std::filesystem::exists(folder)) {
         std::filesystem::create_directories(folder);
@@ -158,6 +202,29 @@ void Recorder::begin(const std::filesystem::path& path, uint32_t width, uint32_t
 
     begin_ffmpeg(path, width, height);
 
+    frame_size = input == Input::YUV420 ? yuv420Size(width, height) : size_t(width) * height * 4;
+    free_buffers.clear();
+    for (uint32_t i = 0; i < buffers.size(); i++) {
+        buffers[i].resize(frame_size);
+        free_buffers.emplace_back(i);
+    }
+    queued = {};
+    stopping = false;
+    encoder_failed = false;
+    next_pts = 0;
+    dropped = 0;
+    spilled = 0;
+    spill_read = 0;
+    if (overflow == Overflow::Spill) {
+        spill_path = path;
+        spill_path += ".spill";
+        spill_out.open(spill_path, std::ios::binary | std::ios::trunc);
+        spill_in.open(spill_path, std::ios::binary);
+        if (!spill_out || !spill_in)
+            throw std::runtime_error("Could not open spill file " + spill_path.string());
+    }
+    encoder = std::thread(&Recorder::encodeLoop, this);
+
     is_recording = true;
     INFO_FILE("recording started");
 }
@@ -199,24 +266,89 @@ void Recorder::encode_frame(AVFormatContext* fmt_ctx, AVCodecContext* codec_ctx,
     }
 }
 
-void Recorder::fill_rgb(AVFrame* frame, uint8_t* data, size_t width, size_t height)
+void Recorder::fill_input(AVFrame* frame, const uint8_t* data) const
 {
-    //! linesize[0] != width * 4, because of padding
-    for (int y = 0; y < height; y++) {
-        memcpy(frame->data[0] + y * frame->linesize[0], // Destination row in AVFrame
-            data + y * width * 4, // Source row in BGRA data
-            width * 4); // Number of bytes to copy per row
+    //! linesize != width * bytes per pixel, because of padding
+    const size_t width = frame->width, height = frame->height;
+    if (input == Input::BGRA) {
+        for (size_t y = 0; y < height; y++)
+            memcpy(frame->data[0] + y * frame->linesize[0], data + y * width * 4, width * 4);
+        return;
+    }
+
+    const Yuv420Layout layout(frame->width, frame->height);
+    const uint8_t* u = data + layout.u_offset;
+    const uint8_t* v = data + layout.v_offset;
+    for (size_t y = 0; y < height; y++)
+        memcpy(frame->data[0] + y * frame->linesize[0], data + y * layout.stride, width);
+    // ffmpeg's chroma planes are rounded up as well
+    const size_t chroma_width = (width + 1) / 2, chroma_height = (height + 1) / 2;
+    for (size_t y = 0; y < chroma_height; y++) {
+        memcpy(frame->data[1] + y * frame->linesize[1], u + y * layout.stride / 2, chroma_width);
+        memcpy(frame->data[2] + y * frame->linesize[2], v + y * layout.stride / 2, chroma_width);
     }
 }
 
-void Recorder::append(std::vector<uint8_t>& data)
+void Recorder::append(const uint8_t* data)
 {
+    PROFILE_SCOPE("Recorder::append");
     if (!is_recording) {
         CRITICAL_FILE("recording not started");
         throw std::runtime_error("recording not started");
         return;
     }
+    if (input == Input::HDR) {
+        exporter.append(data);
+        return;
+    }
+
+    const int64_t pts = next_pts++;
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    if (encoder_failed)
+        throw std::runtime_error("Encoder failed");
+
+    if (overflow == Overflow::Spill && (free_buffers.empty() || spill_read < spilled)) {
+        lock.unlock();
+        spill(data, pts);
+        return;
+    }
+    if (free_buffers.empty() && overflow == Overflow::Drop) {
+        dropped++;
+        return;
+    }
+    free_cv.wait(lock, [this]() { return !free_buffers.empty() || encoder_failed; });
+    if (encoder_failed)
+        throw std::runtime_error("Encoder failed");
+
+    uint32_t buffer = free_buffers.back();
+    free_buffers.pop_back();
+    lock.unlock();
+
+    memcpy(buffers[buffer].data(), data, frame_size);
+
+    lock.lock();
+    queued.push({ buffer, pts });
+    lock.unlock();
+    queued_cv.notify_one();
+}
+
+void Recorder::spill(const uint8_t* data, int64_t pts)
+{
+    spill_out.write(reinterpret_cast<const char*>(&pts), sizeof(pts));
+    spill_out.write(reinterpret_cast<const char*>(data), frame_size);
+    spill_out.flush();
+    if (!spill_out)
+        throw std::runtime_error("Could not write spill file " + spill_path.string());
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        spilled++;
+    }
+    queued_cv.notify_one();
+}
 
+void Recorder::encode(const uint8_t* data, int64_t pts)
+{
+    PROFILE_SCOPE("Recorder::encode");
     auto ret = av_frame_make_writable(ost.frame);
     if (ret < 0) {
         CRITICAL_FILE("Could not make frame writable, error: {}", av_err2str(ret));
@@ -224,23 +356,74 @@ void Recorder::append(std::vector<uint8_t>& data)
         return;
     }
 
-    fill_rgb(ost.rgb_frame, data.data(), ost.codec_ctx->width, ost.codec_ctx->height);
-    ret = sws_scale(
-        ost.sws_ctx,
-        (const uint8_t* const*)ost.rgb_frame->data, ost.rgb_frame->linesize,
-        0, ost.codec_ctx->height,
-        ost.frame->data, ost.frame->linesize);
-    if (ret < 0) {
-        CRITICAL_FILE("Could not scale frame");
-        throw std::runtime_error("Could not scale frame");
-        return;
+    if (ost.sws_ctx == nullptr) {
+        fill_input(ost.frame, data);
+    } else {
+        fill_input(ost.input_frame, data);
+        ret = sws_scale(
+            ost.sws_ctx,
+            (const uint8_t* const*)ost.input_frame->data, ost.input_frame->linesize,
+            0, ost.codec_ctx->height,
+            ost.frame->data, ost.frame->linesize);
+        if (ret < 0) {
+            CRITICAL_FILE("Could not scale frame");
+            throw std::runtime_error("Could not scale frame");
+            return;
+        }
+        TRACE_FILE("sws_scale frame");
     }
-    TRACE_FILE("sws_scale frame");
-    ost.frame->pts = ost.next_pts++;
+    ost.frame->pts = pts;
 
     encode_frame(fmt_ctx, ost.codec_ctx, ost.stream, ost.frame, ost.packet);
 }
 
+void Recorder::encodeLoop()
+{
+    tracer.setThreadName("encoder");
+    std::vector<uint8_t> spilled_frame;
+    try {
+        while (true) {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queued_cv.wait(lock, [this]() { return stopping || !queued.empty() || spill_read < spilled; });
+            // queued frames are always older than spilled ones
+            if (!queued.empty()) {
+                QueuedFrame frame = queued.front();
+                queued.pop();
+                lock.unlock();
+
+                encode(buffers[frame.buffer].data(), frame.pts);
+
+                lock.lock();
+                free_buffers.emplace_back(frame.buffer);
+                lock.unlock();
+                free_cv.notify_one();
+            } else if (spill_read < spilled) {
+                lock.unlock();
+
+                int64_t pts;
+                spilled_frame.resize(frame_size);
+                spill_in.read(reinterpret_cast<char*>(&pts), sizeof(pts));
+                spill_in.read(reinterpret_cast<char*>(spilled_frame.data()), frame_size);
+                if (!spill_in)
+                    throw std::runtime_error("Could not read spill file " + spill_path.string());
+                encode(spilled_frame.data(), pts);
+
+                lock.lock();
+                spill_read++;
+            } else {
+                return;
+            }
+        }
+    } catch (const std::exception& e) {
+        CRITICAL_FILE("Encoder stopped: {}", e.what());
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            encoder_failed = true;
+        }
+        free_cv.notify_all();
+    }
+}
+
 void Recorder::end_ffmpeg()
 {
     // flush the final frames
@@ -256,12 +439,13 @@ void Recorder::end_ffmpeg()
 
     avcodec_free_context(&ost.codec_ctx);
     av_frame_free(&ost.frame);
-    av_frame_free(&ost.rgb_frame);
+    av_frame_free(&ost.input_frame);
     av_packet_free(&ost.packet);
     sws_freeContext(ost.sws_ctx);
     TRACE_FILE("free stream");
 
-    ret = avio_close(fmt_ctx->pb);
+    if (!(fmt_ctx->oformat->flags & AVFMT_NOFILE))
+        ret = avio_close(fmt_ctx->pb);
     if (ret < 0) {
         CRITICAL_FILE("Could not close output file, error: {}", av_err2str(ret));
         throw std::runtime_error("Could not close output file");
@@ -275,6 +459,31 @@ void Recorder::end_ffmpeg()
 
 void Recorder::end()
 {
+    if (flush_pending)
+        flush_pending();
+
+    if (input == Input::HDR) {
+        exporter.end();
+        is_recording = false;
+        INFO_FILE("recording ended");
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queued_cv.notify_one();
+    encoder.join();
+    if (spill_out.is_open()) {
+        spill_out.close();
+        spill_in.close();
+        std::filesystem::remove(spill_path);
+    }
+    if (dropped > 0) {
+        WARN_ALL("Recorder dropped {} of {} frames, the encoder couldn't keep up", dropped, next_pts);
+    }
+
     end_ffmpeg();
 
     is_recording = false;
@@ -283,4 +492,6 @@ void Recorder::end()
 
 void Recorder::destroy()
 {
+    if (is_recording)
+        end();
 }
@@ -1,7 +1,15 @@
 #pragma once
 
+#include "core/tool/frame_exporter.h"
+#include <condition_variable>
 #include <cstdint>
 #include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
 #include <vector>
 
 class Configuration;
@@ -16,20 +24,60 @@ struct OutputStream {
     AVStream* stream;
     AVCodecContext* codec_ctx;
 
-    AVFrame* rgb_frame;
+    // only used when the input has to be converted to the codec's format
+    AVFrame* input_frame;
     AVFrame* frame;
     AVPacket* packet;
 
     SwsContext* sws_ctx;
-
-    int64_t next_pts = 0;
 };
 
+// Frames are copied into pooled buffers and encoded on a worker thread. When
+// all buffers are queued, the overflow policy either blocks the caller, drops
+// the frame or writes it to a spill file the encoder catches up on later.
 class Recorder {
 public:
+    enum class Overflow {
+        Block,
+        Drop,
+        Spill,
+    };
+    enum class Input {
+        // width * height B8G8R8A8 pixels, row by row
+        BGRA,
+        // BT.709 limited range Y plane followed by the U and V planes at half
+        // resolution, laid out as described by Yuv420Layout
+        YUV420,
+        // FrameExporter::frameSize layout, written as image files by the
+        // exporter instead of encoded
+        HDR,
+    };
+    // Planes as RecordYUV writes them: the luma stride is a multiple of 8 and
+    // the rows are rounded up to even, so every 2x8 block fills whole words.
+    // The chroma planes have half the stride and rows, covering the odd
+    // column and row of an odd size as well.
+    struct Yuv420Layout {
+        size_t stride;
+        size_t rows;
+        size_t u_offset;
+        size_t v_offset;
+        size_t size;
+
+        Yuv420Layout(uint32_t width, uint32_t height)
+            : stride((width + 7) & ~7u)
+            , rows((height + 1) & ~1u)
+            , u_offset(stride * rows)
+            , v_offset(u_offset + stride / 2 * rows / 2)
+            , size(stride * rows * 3 / 2)
+        {
+        }
+    };
+    static size_t yuv420Size(uint32_t width, uint32_t height) { return Yuv420Layout(width, height).size; }
+
     void init(const Configuration& config);
     void begin(const std::filesystem::path& path, uint32_t width, uint32_t height);
-    void append(std::vector<uint8_t>& data);
+    // one frame in the input format
+    void append(const uint8_t* data);
     void end();
     void destroy();
 
@@ -37,14 +85,55 @@ public:
     void end_ffmpeg();
 
     bool is_recording = false;
+    // set before begin by whoever provides the frames
+    Input input = Input::BGRA;
+    // set by whoever reads frames back asynchronously, end() calls it so the
+    // frames still in flight make it into the file
+    std::function<void()> flush_pending;
 
 private:
     static void encode_frame(AVFormatContext* fmt_ctx, AVCodecContext* codec_ctx, AVStream* stream, AVFrame* frame, AVPacket* packet);
-    static void fill_rgb(AVFrame* frame, uint8_t* data, size_t width, size_t height);
+    void fill_input(AVFrame* frame, const uint8_t* data) const;
+
+    struct QueuedFrame {
+        uint32_t buffer;
+        int64_t pts;
+    };
+    void encodeLoop();
+    void encode(const uint8_t* data, int64_t pts);
+    void spill(const uint8_t* data, int64_t pts);
 
     AVFormatContext* fmt_ctx = nullptr;
     OutputStream ost;
 
     int64_t bit_rate = 0;
     int frame_rate = 0;
+    std::string preset;
+    int encoder_threads = 0;
+    Overflow overflow = Overflow::Block;
+    FrameExporter exporter;
+
+    std::thread encoder;
+    std::mutex queue_mutex;
+    // signaled when a frame is queued or spilled and when stopping
+    std::condition_variable queued_cv;
+    // signaled when the encoder returns a buffer
+    std::condition_variable free_cv;
+    std::vector<std::vector<uint8_t>> buffers;
+    std::vector<uint32_t> free_buffers;
+    std::queue<QueuedFrame> queued;
+    bool stopping = false;
+    bool encoder_failed = false;
+    size_t frame_size = 0;
+    // presentation time of the next appended frame, dropped frames leave gaps
+    int64_t next_pts = 0;
+    uint64_t dropped = 0;
+
+    // Once a frame is spilled every later one is too until the encoder read
+    // them all back, which keeps the frames in order.
+    std::filesystem::path spill_path;
+    std::ofstream spill_out;
+    std::ifstream spill_in;
+    uint64_t spilled = 0;
+    uint64_t spill_read = 0;
 };
@@ -0,0 +1,109 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(uint32_t thread_count)
+{
+    if (thread_count == 0)
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    workers.reserve(thread_count);
+    for (uint32_t i = 0; i < thread_count; i++)
+        workers.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::work()
+{
+    while (true) {
+        std::function<void()> task;
+        Batch* running = nullptr;
+        uint64_t run = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]() { return stopping || !tasks.empty() || batch != nullptr; });
+            if (!tasks.empty()) {
+                task = std::move(tasks.front());
+                tasks.pop();
+            } else if (batch != nullptr) {
+                running = batch;
+                run = batch_run;
+            } else {
+                return;
+            }
+        }
+        if (task) {
+            task();
+            continue;
+        }
+
+        for (uint32_t i = running->next++; i < running->count; i = running->next++) {
+            running->fn(i);
+            if (--running->remaining == 0)
+                running->remaining.notify_all();
+        }
+        // every job of the run is taken
+        std::lock_guard<std::mutex> lock(mutex);
+        if (batch_run == run)
+            batch = nullptr;
+    }
+}
+
+void ThreadPool::run(Batch& batch)
+{
+    if (batch.count == 0)
+        return;
+
+    batch.remaining.store(batch.count);
+    batch.next.store(0);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->batch = &batch;
+        batch_run++;
+    }
+    cv.notify_all();
+}
+
+void ThreadPool::wait(Batch& batch)
+{
+    for (uint32_t remaining = batch.remaining.load(); remaining != 0; remaining = batch.remaining.load())
+        batch.remaining.wait(remaining);
+}
+
+void ThreadPool::parallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t, uint32_t)>& fn)
+{
+    if (begin >= end)
+        return;
+
+    uint32_t count = end - begin;
+    uint32_t chunk_count = std::min(count, (size() + 1) * 4);
+    uint32_t chunk_size = (count + chunk_count - 1) / chunk_count;
+    chunk_count = (count + chunk_size - 1) / chunk_size;
+
+    std::atomic<uint32_t> next_chunk = 0;
+    auto run_chunks = [&]() {
+        for (uint32_t c = next_chunk++; c < chunk_count; c = next_chunk++) {
+            uint32_t chunk_begin = begin + c * chunk_size;
+            fn(chunk_begin, std::min(chunk_begin + chunk_size, end));
+        }
+    };
+
+    std::vector<std::future<void>> helpers;
+    uint32_t helper_count = std::min(size(), chunk_count - 1);
+    helpers.reserve(helper_count);
+    for (uint32_t i = 0; i < helper_count; i++)
+        helpers.emplace_back(submit(run_chunks));
+    run_chunks();
+    for (auto& helper : helpers)
+        helper.get();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool {
+public:
+    // A fixed set of jobs, fn(i) runs job i. Built once and handed to run()
+    // as often as needed, running it allocates nothing. fn must not throw.
+    struct Batch {
+        std::function<void(uint32_t)> fn;
+        uint32_t count = 0;
+        // next job to take and jobs not finished yet in the current run
+        std::atomic<uint32_t> next = 0;
+        std::atomic<uint32_t> remaining = 0;
+    };
+
+    // 0 picks one worker per hardware thread
+    explicit ThreadPool(uint32_t thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <typename F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<F>>
+    {
+        using R = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        auto result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace([task]() { (*task)(); });
+        }
+        cv.notify_one();
+        return result;
+    }
+
+    // Splits [begin, end) into chunks and blocks until all of them ran.
+    // The calling thread works on chunks as well.
+    void parallelFor(uint32_t begin, uint32_t end, const std::function<void(uint32_t, uint32_t)>& fn);
+
+    // Starts the jobs of batch on the workers and returns right away. batch
+    // must not be changed or run again before wait(batch) returned.
+    void run(Batch& batch);
+    static void wait(Batch& batch);
+
+    uint32_t size() const { return static_cast<uint32_t>(workers.size()); }
+
+private:
+    void work();
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    // the batch running, workers take its jobs once the task queue is empty
+    Batch* batch = nullptr;
+    // counts the runs, so a worker only clears the batch it took jobs from
+    uint64_t batch_run = 0;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+};
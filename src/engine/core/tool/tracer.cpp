@@ -0,0 +1,100 @@
+#include "tracer.h"
+#include "core/config/config.h"
+#include "core/tool/logger.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+Tracer tracer;
+
+void Tracer::init(const TracerConfiguration& config)
+{
+    output_path = config.output_path;
+    is_enabled.store(config.enabled, std::memory_order_relaxed);
+    setThreadName("main");
+}
+
+Tracer::ThreadBuffer& Tracer::threadBuffer()
+{
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer != nullptr)
+        return *buffer;
+
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    auto& created = buffers.emplace_back(std::make_unique<ThreadBuffer>());
+    created->id = static_cast<uint32_t>(buffers.size());
+    created->name = "thread " + std::to_string(created->id);
+    created->events = std::make_unique<EventSlot[]>(EVENTS_PER_THREAD);
+    buffer = created.get();
+    return *buffer;
+}
+
+void Tracer::setThreadName(const std::string& name)
+{
+    auto& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    buffer.name = name;
+}
+
+void Tracer::record(const char* name, int64_t begin_ns, int64_t end_ns)
+{
+    auto& buffer = threadBuffer();
+    uint64_t index = buffer.count.load(std::memory_order_relaxed);
+    buffer.claimed.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    auto& slot = buffer.events[index % EVENTS_PER_THREAD];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.begin_ns.store(begin_ns, std::memory_order_relaxed);
+    slot.end_ns.store(end_ns, std::memory_order_relaxed);
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::dump(const std::string& path)
+{
+    std::filesystem::path file_path = path.empty() ? output_path : path;
+    if (file_path.has_parent_path())
+        std::filesystem::create_directories(file_path.parent_path());
+    std::ofstream out(file_path);
+    if (!out) {
+        ERROR_ALL("Could not open {} for the trace", file_path.string());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    size_t event_count = 0;
+    std::vector<Event> events;
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    for (const auto& buffer : buffers) {
+        out << (first ? "" : ",") << "\n"
+            << fmt::format(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{}"}}}})", buffer->id, buffer->name);
+        first = false;
+
+        // copy the events first, the thread may keep recording meanwhile
+        uint64_t count = buffer->count.load(std::memory_order_acquire);
+        uint64_t begin = count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0;
+        events.clear();
+        for (uint64_t i = begin; i < count; i++) {
+            const auto& slot = buffer->events[i % EVENTS_PER_THREAD];
+            events.push_back({
+                slot.name.load(std::memory_order_relaxed),
+                slot.begin_ns.load(std::memory_order_relaxed),
+                slot.end_ns.load(std::memory_order_relaxed),
+            });
+        }
+        // events whose slot was claimed again since may be torn
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t claimed = buffer->claimed.load(std::memory_order_relaxed);
+        uint64_t valid = claimed > EVENTS_PER_THREAD ? claimed - EVENTS_PER_THREAD : 0;
+        for (uint64_t i = std::max(begin, valid); i < count; i++) {
+            const auto& event = events[i - begin];
+            out << ",\n"
+                << fmt::format(R"({{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+                       event.name, buffer->id, event.begin_ns / 1e3, (event.end_ns - event.begin_ns) / 1e3);
+            event_count++;
+        }
+    }
+    out << "\n]}\n";
+
+    INFO_ALL("Wrote {} trace events of {} threads to {}", event_count, buffers.size(), file_path.string());
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct TracerConfiguration;
+
+// Scoped CPU markers dumped as Chrome trace events, open the file in
+// chrome://tracing or ui.perfetto.dev. Every thread writes to its own buffer
+// without locking, names must be string literals.
+class Tracer {
+public:
+    // events kept per thread, older ones are overwritten
+    static constexpr uint64_t EVENTS_PER_THREAD = 1 << 16;
+
+    void init(const TracerConfiguration& config);
+    bool enabled() const { return is_enabled.load(std::memory_order_relaxed); }
+    // shown instead of the thread id in the trace
+    void setThreadName(const std::string& name);
+    void record(const char* name, int64_t begin_ns, int64_t end_ns);
+    // writes the events of all threads, to output_path if path is empty
+    void dump(const std::string& path = "");
+
+    int64_t now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    struct Event {
+        const char* name;
+        int64_t begin_ns;
+        int64_t end_ns;
+    };
+    // atomic so dump can read slots the owning thread overwrites meanwhile
+    struct EventSlot {
+        std::atomic<const char*> name;
+        std::atomic<int64_t> begin_ns;
+        std::atomic<int64_t> end_ns;
+    };
+    struct ThreadBuffer {
+        uint32_t id;
+        std::string name;
+        std::unique_ptr<EventSlot[]> events;
+        // Written by the owning thread only. Events below count are complete,
+        // claimed is raised before a slot is overwritten, so dump can drop the
+        // events overwritten while it read them.
+        std::atomic<uint64_t> count = 0;
+        std::atomic<uint64_t> claimed = 0;
+    };
+    ThreadBuffer& threadBuffer();
+
+    std::atomic<bool> is_enabled = false;
+    std::string output_path;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // only taken when a thread records its first event and for dumping
+    std::mutex buffers_mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+extern Tracer tracer;
+
+class TraceScope {
+    const char* name;
+    int64_t begin_ns;
+
+public:
+    explicit TraceScope(const char* name)
+        : name(name)
+        , begin_ns(tracer.enabled() ? tracer.now() : -1)
+    {
+    }
+    ~TraceScope()
+    {
+        if (begin_ns >= 0)
+            tracer.record(name, begin_ns, tracer.now());
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define PROFILE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Vk {
+
+// Identifies one registration: the generation of the slot, the type and the
+// handle. Lookups with a key fail once it was removed, even if its slot was
+// reused since.
+enum class DescriptorKey : uint64_t {
+    Null = static_cast<uint64_t>(-1),
+};
+}
@@ -10,7 +10,6 @@ void DescriptorManager::init(Context* ctx)
 
     initBindlessDescriptors();
     initBindlessTable();
-    initParameters();
     initUI();
 }
 
@@ -23,7 +22,9 @@ void DescriptorManager::initBindlessDescriptors()
         bindings[i].descriptorType = types[i];
         bindings[i].descriptorCount = MAX_TYPE_DESCRIPTORS[i];
         bindings[i].stageFlags = VK_SHADER_STAGE_ALL;
-        flags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+        flags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+            | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+            | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
     }
     VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlags {};
     bindingFlags.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
@@ -65,43 +66,56 @@ void DescriptorManager::initBindlessDescriptors()
 void DescriptorManager::initBindlessTable()
 {
     for (uint32_t i = 0; i < TYPE_COUNT; ++i) {
-        const auto& type = static_cast<DescriptorType>(i);
-        allocatedHandles[type] = {};
-        freeHandles[type].reserve(MAX_TYPE_DESCRIPTORS[i]);
-        for (uint32_t j = 0; j < MAX_TYPE_DESCRIPTORS[i]; ++j)
-            freeHandles[type].insert(static_cast<DescriptorHandle>(j));
+        auto& table = slots[i];
+        table.generations.assign(MAX_TYPE_DESCRIPTORS[i], 0);
+        table.owners.assign(MAX_TYPE_DESCRIPTORS[i], uuid::nil_uuid());
+        table.retired.resize(ctx->framesInFlight);
+        table.pending.assign(MAX_TYPE_DESCRIPTORS[i], NO_PENDING_WRITE);
+        // lowest handles on top
+        table.free.reserve(MAX_TYPE_DESCRIPTORS[i]);
+        for (uint32_t j = MAX_TYPE_DESCRIPTORS[i]; j > 0; --j)
+            table.free.emplace_back(static_cast<DescriptorHandle>(j - 1));
     }
+    keys.reserve(MAX_UNIFORM_DESCRIPTORS + MAX_STORAGE_DESCRIPTORS + MAX_COMBINED_IMAGE_SAMPLER_DESCRIPTORS);
 }
 
-void DescriptorManager::initParameters()
+void DescriptorManager::beginFrame(uint32_t slot)
 {
-    VkDescriptorSetLayoutBinding layoutBinding = {};
-    layoutBinding.binding = 0;
-    layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    layoutBinding.descriptorCount = 1;
-    layoutBinding.stageFlags = VK_SHADER_STAGE_ALL;
-
-    VkDescriptorSetLayoutCreateInfo layoutInfo {};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = 1;
-    layoutInfo.pBindings = &layoutBinding;
-    if (vkCreateDescriptorSetLayout(ctx->device, &layoutInfo, nullptr, &parameterLayout) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create descriptor set layout!");
+    std::lock_guard<std::mutex> lock(mutex);
+    frameSlot = slot;
+    for (auto& table : slots) {
+        auto& retired = table.retired[slot];
+        table.free.insert(table.free.end(), retired.begin(), retired.end());
+        retired.clear();
     }
+}
 
-    VkDescriptorPoolSize poolSize {};
-    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSize.descriptorCount = parameterPoolSize;
+DescriptorKey DescriptorManager::allocate(const uuid::UUID& id, DescriptorType type)
+{
+    auto& table = slots[static_cast<uint32_t>(type)];
+    if (table.free.empty())
+        throw std::runtime_error("failed to allocate descriptor handle!");
+    if (keys.find(id) != keys.end())
+        throw std::runtime_error("register the same uuid again!");
 
-    VkDescriptorPoolCreateInfo poolInfo {};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = 1;
-    poolInfo.pPoolSizes = &poolSize;
-    poolInfo.maxSets = parameterPoolSize;
-    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
-    if (vkCreateDescriptorPool(ctx->device, &poolInfo, nullptr, &parameterPool) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create descriptor pool!");
-    }
+    const auto handle = table.free.back();
+    table.free.pop_back();
+    table.owners[static_cast<uint32_t>(handle)] = id;
+    const auto key = static_cast<DescriptorKey>(
+        static_cast<uint64_t>(table.generations[static_cast<uint32_t>(handle)]) << 32
+        | static_cast<uint64_t>(type) << 24
+        | static_cast<uint64_t>(handle));
+    keys.emplace(id, key);
+    return key;
+}
+
+void DescriptorManager::checkKey(DescriptorKey key) const
+{
+    if (key == DescriptorKey::Null)
+        throw std::runtime_error("null descriptor key!");
+    const auto& table = slots[static_cast<uint32_t>(typeOf(key))];
+    if (table.generations[static_cast<uint32_t>(handleOf(key))] != generationOf(key))
+        throw std::runtime_error("stale descriptor key!");
 }
 
 void DescriptorManager::initUI()
@@ -121,260 +135,164 @@ void DescriptorManager::initUI()
     }
 }
 
-DescriptorHandle DescriptorManager::registerResource(const Image& image, DescriptorType type)
+void DescriptorManager::queueWrite(DescriptorType type, DescriptorHandle handle, bool live, const VkDescriptorImageInfo* image, const VkDescriptorBufferInfo* buffer)
 {
-    assert(image.id != uuid::nil_uuid());
-    assert(type == DescriptorType::CombinedImageSampler);
-    if (freeHandles[type].empty()) {
-        assert(allocatedHandles[type].size() == MAX_TYPE_DESCRIPTORS[static_cast<uint32_t>(type)]);
-        throw std::runtime_error("failed to allocate descriptor handle!");
+    auto& index = slots[static_cast<uint32_t>(type)].pending[static_cast<uint32_t>(handle)];
+    if (index == NO_PENDING_WRITE) {
+        index = static_cast<uint32_t>(pendingWrites.size());
+        pendingWrites.emplace_back();
+        pendingWrites[index].live = live;
     }
-    assert(allocatedHandles[type].size() < MAX_TYPE_DESCRIPTORS[static_cast<uint32_t>(type)]);
+    // a slot whose first write is still queued isn't read by anyone yet
+    auto& write = pendingWrites[index];
+    write.type = type;
+    write.handle = handle;
+    if (image != nullptr)
+        write.image = *image;
+    if (buffer != nullptr)
+        write.buffer = *buffer;
+}
 
-    const auto handle = *freeHandles[type].begin();
-    freeHandles[type].erase(freeHandles[type].begin());
-    allocatedHandles[type][image.id] = handle;
-    nameToType[image.id] = type;
+void DescriptorManager::flush()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pendingWrites.empty())
+        return;
+
+    bool live = false;
+    std::vector<VkWriteDescriptorSet> writes;
+    writes.reserve(pendingWrites.size());
+    for (const auto& pending : pendingWrites) {
+        if (pending.handle == DescriptorHandle::Null)
+            continue;
+        live = live || pending.live;
+        slots[static_cast<uint32_t>(pending.type)].pending[static_cast<uint32_t>(pending.handle)] = NO_PENDING_WRITE;
+
+        VkWriteDescriptorSet descriptorWrite {};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = bindlessSet;
+        descriptorWrite.dstBinding = static_cast<uint32_t>(pending.type);
+        descriptorWrite.dstArrayElement = static_cast<uint32_t>(pending.handle);
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.descriptorType = types[static_cast<uint32_t>(pending.type)];
+        if (pending.type == DescriptorType::CombinedImageSampler)
+            descriptorWrite.pImageInfo = &pending.image;
+        else
+            descriptorWrite.pBufferInfo = &pending.buffer;
+        writes.emplace_back(descriptorWrite);
+    }
+
+    // Fresh slots were retired for a full round of frames, no pending command
+    // buffer reads them. A live slot may be read by every frame in flight.
+    if (live) {
+        for (uint32_t i = 0; i < ctx->framesInFlight; i++) {
+            if (i != frameSlot)
+                vkWaitForFences(ctx->device, 1, &ctx->inFlightFences[i], VK_TRUE, UINT64_MAX);
+        }
+    }
+    vkUpdateDescriptorSets(ctx->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    pendingWrites.clear();
+}
 
+DescriptorKey DescriptorManager::registerResource(Image& image, DescriptorType type)
+{
+    return registerResource(image, type, image.layout);
+}
+
+DescriptorKey DescriptorManager::registerResource(Image& image, DescriptorType type, VkImageLayout layout)
+{
+    assert(image.id != uuid::nil_uuid());
+    assert(type == DescriptorType::CombinedImageSampler);
     assert(image.sampler != VK_NULL_HANDLE);
     VkDescriptorImageInfo imageInfo {};
-    imageInfo.imageLayout = image.layout;
+    imageInfo.imageLayout = layout;
     imageInfo.imageView = image.view;
     imageInfo.sampler = image.sampler;
 
-    VkWriteDescriptorSet descriptorWrite {};
-    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorWrite.dstSet = bindlessSet;
-    descriptorWrite.dstBinding = static_cast<uint32_t>(type);
-    descriptorWrite.dstArrayElement = static_cast<uint32_t>(handle);
-    descriptorWrite.descriptorCount = 1;
-    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptorWrite.pImageInfo = &imageInfo;
-    vkUpdateDescriptorSets(ctx->device, 1, &descriptorWrite, 0, nullptr);
-
-    return handle;
+    std::lock_guard<std::mutex> lock(mutex);
+    image.descriptor = allocate(image.id, type);
+    queueWrite(type, handleOf(image.descriptor), false, &imageInfo, nullptr);
+    return image.descriptor;
 }
 
-DescriptorHandle DescriptorManager::registerResource(const Buffer& buffer, DescriptorType type)
+DescriptorKey DescriptorManager::registerResource(Buffer& buffer, DescriptorType type)
 {
     assert(buffer.id != uuid::nil_uuid());
     assert(type == DescriptorType::Uniform || type == DescriptorType::Storage);
-    if (freeHandles[type].empty()) {
-        assert(allocatedHandles[type].size() == MAX_TYPE_DESCRIPTORS[static_cast<uint32_t>(type)]);
-        throw std::runtime_error("failed to allocate descriptor handle!");
-    }
-    assert(allocatedHandles[type].size() < MAX_TYPE_DESCRIPTORS[static_cast<uint32_t>(type)]);
-
-    const auto handle = *freeHandles[type].begin();
-    freeHandles[type].erase(freeHandles[type].begin());
-    allocatedHandles[type][buffer.id] = handle;
-    nameToType[buffer.id] = type;
-
     VkDescriptorBufferInfo bufferInfo {};
     bufferInfo.buffer = buffer.buffer;
     bufferInfo.offset = 0;
     bufferInfo.range = VK_WHOLE_SIZE;
 
-    VkWriteDescriptorSet descriptorWrite {};
-    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorWrite.dstSet = bindlessSet;
-    descriptorWrite.dstBinding = static_cast<uint32_t>(type);
-    descriptorWrite.dstArrayElement = static_cast<uint32_t>(handle);
-    descriptorWrite.descriptorCount = 1;
-    descriptorWrite.pBufferInfo = &bufferInfo;
-    if (type == DescriptorType::Uniform)
-        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    if (type == DescriptorType::Storage)
-        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    vkUpdateDescriptorSets(ctx->device, 1, &descriptorWrite, 0, nullptr);
-
-    return handle;
+    std::lock_guard<std::mutex> lock(mutex);
+    buffer.descriptor = allocate(buffer.id, type);
+    queueWrite(type, handleOf(buffer.descriptor), false, nullptr, &bufferInfo);
+    return buffer.descriptor;
 }
 
 void DescriptorManager::updateResourceRegistration(const Image& image)
 {
-    assert(image.id != uuid::nil_uuid());
-    const auto& type = nameToType.find(image.id);
-    if (type == nameToType.end())
-        throw std::runtime_error("failed to find the descriptor!");
-    const auto& handle = allocatedHandles[type->second].find(image.id);
-    if (handle == allocatedHandles[type->second].end())
-        throw std::runtime_error("failed to find the descriptor!");
-
     assert(image.sampler != VK_NULL_HANDLE);
     VkDescriptorImageInfo imageInfo {};
     imageInfo.imageLayout = image.layout;
     imageInfo.imageView = image.view;
     imageInfo.sampler = image.sampler;
 
-    VkWriteDescriptorSet descriptorWrite {};
-    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorWrite.dstSet = bindlessSet;
-    descriptorWrite.dstBinding = static_cast<uint32_t>(type->second);
-    descriptorWrite.dstArrayElement = static_cast<uint32_t>(handle->second);
-    descriptorWrite.descriptorCount = 1;
-    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptorWrite.pImageInfo = &imageInfo;
-    vkUpdateDescriptorSets(ctx->device, 1, &descriptorWrite, 0, nullptr);
+    std::lock_guard<std::mutex> lock(mutex);
+    checkKey(image.descriptor);
+    queueWrite(typeOf(image.descriptor), handleOf(image.descriptor), true, &imageInfo, nullptr);
 }
 
 void DescriptorManager::updateResourceRegistration(const Buffer& buffer)
 {
-    assert(buffer.id != uuid::nil_uuid());
-    const auto& type = nameToType.find(buffer.id);
-    if (type == nameToType.end())
-        throw std::runtime_error("failed to find the descriptor!");
-    const auto& handle = allocatedHandles[type->second].find(buffer.id);
-    if (handle == allocatedHandles[type->second].end())
-        throw std::runtime_error("failed to find the descriptor!");
-
     VkDescriptorBufferInfo bufferInfo {};
     bufferInfo.buffer = buffer.buffer;
     bufferInfo.offset = 0;
     bufferInfo.range = VK_WHOLE_SIZE;
 
-    VkWriteDescriptorSet descriptorWrite {};
-    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorWrite.dstSet = bindlessSet;
-    descriptorWrite.dstBinding = static_cast<uint32_t>(type->second);
-    descriptorWrite.dstArrayElement = static_cast<uint32_t>(handle->second);
-    descriptorWrite.descriptorCount = 1;
-    descriptorWrite.pBufferInfo = &bufferInfo;
-    if (type->second == DescriptorType::Uniform)
-        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    if (type->second == DescriptorType::Storage)
-        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    vkUpdateDescriptorSets(ctx->device, 1, &descriptorWrite, 0, nullptr);
+    std::lock_guard<std::mutex> lock(mutex);
+    checkKey(buffer.descriptor);
+    queueWrite(typeOf(buffer.descriptor), handleOf(buffer.descriptor), true, nullptr, &bufferInfo);
 }
 
-DescriptorHandle DescriptorManager::getResourceHandle(const uuid::UUID& id)
+DescriptorHandle DescriptorManager::getResourceHandle(DescriptorKey key) const
 {
-    assert(id != uuid::nil_uuid());
-    const auto& type = nameToType.find(id);
-    if (type == nameToType.end())
-        throw std::runtime_error("failed to find the descriptor!");
-    const auto& handle = allocatedHandles[type->second].find(id);
-    if (handle == allocatedHandles[type->second].end())
-        throw std::runtime_error("failed to find the descriptor!");
-    return handle->second;
+    std::lock_guard<std::mutex> lock(mutex);
+    checkKey(key);
+    return handleOf(key);
 }
 
-void DescriptorManager::removeResourceRegistration(const uuid::UUID& id)
+void DescriptorManager::removeResourceRegistration(Image& image)
 {
-    assert(id != uuid::nil_uuid());
-    const auto& type = nameToType.find(id);
-    if (type == nameToType.end())
-        throw std::runtime_error("failed to find the descriptor!");
-    const auto& handle = allocatedHandles[type->second].find(id);
-    if (handle == allocatedHandles[type->second].end())
-        throw std::runtime_error("failed to find the descriptor!");
-    freeHandles[type->second].emplace(handle->second);
-    allocatedHandles[type->second].erase(id);
-    nameToType.erase(id);
+    removeResourceRegistration(image.descriptor);
+    image.descriptor = DescriptorKey::Null;
 }
 
-void DescriptorManager::resizeParameterPool()
+void DescriptorManager::removeResourceRegistration(Buffer& buffer)
 {
-    auto new_size = parameterPoolSize * 2;
-
-    VkDescriptorPool new_pool;
-    VkDescriptorPoolSize poolSize {};
-    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSize.descriptorCount = new_size;
-    VkDescriptorPoolCreateInfo poolInfo {};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = 1;
-    poolInfo.pPoolSizes = &poolSize;
-    poolInfo.maxSets = new_size;
-    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
-    if (vkCreateDescriptorPool(ctx->device, &poolInfo, nullptr, &new_pool) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create descriptor pool!");
-    }
-
-    std::vector<VkDescriptorSet> sets(new_size);
-    VkDescriptorSetAllocateInfo allocInfo {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = new_pool;
-    allocInfo.descriptorSetCount = sets.size();
-    allocInfo.pSetLayouts = &parameterLayout;
-    if (vkAllocateDescriptorSets(ctx->device, &allocInfo, sets.data()) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate descriptor sets!");
-    }
-    std::vector<VkCopyDescriptorSet> copies(sets.size());
-    int i = 0;
-    for (auto& p : parameterSet) {
-        copies[i].sType = VK_STRUCTURE_TYPE_COPY_DESCRIPTOR_SET;
-        copies[i].srcSet = p.second; // Source descriptor set
-        copies[i].srcBinding = 0; // Source binding
-        copies[i].srcArrayElement = 0; // Starting array index in source
-        copies[i].dstSet = sets[i]; // Destination descriptor set
-        copies[i].dstBinding = 0; // Destination binding
-        copies[i].dstArrayElement = 0; // Starting array index in destination
-        copies[i].descriptorCount = 1; // Number of descriptors to copy
-
-        p.second = sets[i];
-        i++;
-    }
-    vkUpdateDescriptorSets(ctx->device, 0, nullptr, copies.size(), copies.data());
-
-    vkDestroyDescriptorPool(ctx->device, parameterPool, nullptr);
-    parameterPool = new_pool;
-    parameterPoolSize = new_size;
+    removeResourceRegistration(buffer.descriptor);
+    buffer.descriptor = DescriptorKey::Null;
 }
 
-void DescriptorManager::registerParameter(const Buffer& buffer)
+void DescriptorManager::removeResourceRegistration(DescriptorKey key)
 {
-    assert(buffer.id != uuid::nil_uuid());
-    if (parameterSet.find(buffer.id) != parameterSet.end())
-        throw std::runtime_error("register the same uuid again!");
-
-    if (parameterSet.size() == parameterPoolSize)
-        resizeParameterPool();
-
-    VkDescriptorSet desc_set;
-    VkDescriptorSetAllocateInfo allocInfo {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = parameterPool;
-    allocInfo.descriptorSetCount = 1;
-    allocInfo.pSetLayouts = &parameterLayout;
-    if (vkAllocateDescriptorSets(ctx->device, &allocInfo, &desc_set) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate descriptor sets!");
-    }
-    VkDescriptorBufferInfo bufferInfo {};
-    bufferInfo.buffer = buffer.buffer;
-    bufferInfo.offset = 0;
-    bufferInfo.range = VK_WHOLE_SIZE;
-
-    VkWriteDescriptorSet descriptorWrite {};
-    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorWrite.dstSet = desc_set;
-    descriptorWrite.dstBinding = 0;
-    descriptorWrite.dstArrayElement = 0;
-    descriptorWrite.descriptorCount = 1;
-    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    descriptorWrite.pBufferInfo = &bufferInfo;
-    vkUpdateDescriptorSets(ctx->device, 1, &descriptorWrite, 0, nullptr);
-
-    parameterSet[buffer.id] = desc_set;
+    std::lock_guard<std::mutex> lock(mutex);
+    removeKey(key);
 }
 
-VkDescriptorSet* DescriptorManager::getParameterSet(const uuid::UUID& uuid)
+void DescriptorManager::removeKey(DescriptorKey key)
 {
-    assert(uuid != uuid::nil_uuid());
-    const auto it = parameterSet.find(uuid);
-    if (it == parameterSet.end())
-        throw std::runtime_error("failed to find the descriptor set!");
-    return &it->second;
-}
-
-void DescriptorManager::removeParameter(const uuid::UUID& uuid)
-{
-    assert(uuid != uuid::nil_uuid());
-    const auto it = parameterSet.find(uuid);
-    if (it == parameterSet.end())
-        throw std::runtime_error("failed to find the descriptor set!");
-    vkFreeDescriptorSets(ctx->device, parameterPool, 1, &it->second);
-    parameterSet.erase(it);
+    checkKey(key);
+    const auto handle = static_cast<uint32_t>(handleOf(key));
+    auto& table = slots[static_cast<uint32_t>(typeOf(key))];
+    if (table.pending[handle] != NO_PENDING_WRITE) {
+        pendingWrites[table.pending[handle]].handle = DescriptorHandle::Null;
+        table.pending[handle] = NO_PENDING_WRITE;
+    }
+    keys.erase(table.owners[handle]);
+    table.owners[handle] = uuid::nil_uuid();
+    table.generations[handle]++;
+    table.retired[frameSlot].emplace_back(handleOf(key));
 }
 
 void DescriptorManager::cleanup()
@@ -382,9 +300,6 @@ void DescriptorManager::cleanup()
     vkDestroyDescriptorSetLayout(ctx->device, bindlessLayout, nullptr);
     vkDestroyDescriptorPool(ctx->device, bindlessPool, nullptr);
 
-    vkDestroyDescriptorSetLayout(ctx->device, parameterLayout, nullptr);
-    vkDestroyDescriptorPool(ctx->device, parameterPool, nullptr);
-
     vkDestroyDescriptorPool(ctx->device, uiPool, nullptr);
 }
 }
@@ -1,11 +1,13 @@
 #pragma once
 
+#include "core/vulkan/descriptor_key.h"
 #include "core/vulkan/type/image.h"
 #include <array>
 #include <boost/uuid/uuid.hpp>
 #include <core/tool/uuid.h>
+#include <mutex>
 #include <unordered_map>
-#include <unordered_set>
+#include <vector>
 #include <vulkan/vulkan.h>
 
 namespace Vk {
@@ -27,43 +29,94 @@ enum class DescriptorType : uint8_t {
 class DescriptorManager {
     void initBindlessDescriptors();
     void initBindlessTable();
-    void initParameters();
     void initUI();
 
-    void resizeParameterPool();
-
     Context* ctx;
 
     VkDescriptorPool bindlessPool;
     VkDescriptorSetLayout bindlessLayout;
     VkDescriptorSet bindlessSet;
-    std::unordered_map<DescriptorType, std::unordered_set<DescriptorHandle>> freeHandles;
-    std::unordered_map<DescriptorType, std::unordered_map<uuid::UUID, DescriptorHandle>> allocatedHandles;
-    std::unordered_map<uuid::UUID, DescriptorType> nameToType;
 
-    VkDescriptorPool parameterPool;
-    VkDescriptorSetLayout parameterLayout;
-    std::unordered_map<uuid::UUID, VkDescriptorSet> parameterSet;
-    uint32_t parameterPoolSize = 128;
+    // Slot map per type indexed by handle. Removed handles are retired with
+    // the frame slot they were removed in and only pushed back on the free
+    // stack once that slot's fence was waited on, so no frame in flight sees
+    // its descriptor rewritten.
+    struct SlotTable {
+        std::vector<uint32_t> generations;
+        std::vector<uuid::UUID> owners;
+        std::vector<DescriptorHandle> free;
+        std::vector<std::vector<DescriptorHandle>> retired;
+        // index of the queued write per handle
+        std::vector<uint32_t> pending;
+    };
+    std::array<SlotTable, static_cast<size_t>(DescriptorType::Count)> slots;
+    std::unordered_map<uuid::UUID, DescriptorKey> keys;
+    uint32_t frameSlot = 0;
+
+    // Writes are queued, later writes to the same handle replace earlier ones.
+    // live is set for handles that were written before, which frames in
+    // flight may read.
+    struct PendingWrite {
+        DescriptorType type;
+        // Null once the registration was removed again
+        DescriptorHandle handle;
+        bool live;
+        VkDescriptorImageInfo image;
+        VkDescriptorBufferInfo buffer;
+    };
+    static constexpr uint32_t NO_PENDING_WRITE = static_cast<uint32_t>(-1);
+    std::vector<PendingWrite> pendingWrites;
+    // guards the slot tables and the queued writes, registrations may come
+    // from worker threads
+    mutable std::mutex mutex;
+
+    DescriptorKey allocate(const uuid::UUID& id, DescriptorType type);
+    void checkKey(DescriptorKey key) const;
+    void removeKey(DescriptorKey key);
+    void queueWrite(DescriptorType type, DescriptorHandle handle, bool live, const VkDescriptorImageInfo* image, const VkDescriptorBufferInfo* buffer);
 
 public:
     DescriptorManager() = default;
     void init(Context* ctx);
 
-    DescriptorHandle registerResource(const Image& image, DescriptorType type = DescriptorType::CombinedImageSampler);
-    DescriptorHandle registerResource(const Buffer& buffer, DescriptorType type);
+    // call after the fence of slot was waited on, frees the handles removed
+    // framesInFlight frames ago
+    void beginFrame(uint32_t slot);
+    // Applies the queued descriptor writes in one call, before the frame's
+    // commands are recorded. Rewriting a handle that was already flushed
+    // waits for the other frames in flight.
+    void flush();
+
+    // the key is also stored in the resource's descriptor
+    DescriptorKey registerResource(Image& image, DescriptorType type = DescriptorType::CombinedImageSampler);
+    // for images that are in another layout whenever they are sampled
+    DescriptorKey registerResource(Image& image, DescriptorType type, VkImageLayout layout);
+    DescriptorKey registerResource(Buffer& buffer, DescriptorType type);
+    // registrations and updates only take effect with the next flush
     void updateResourceRegistration(const Image& image);
     void updateResourceRegistration(const Buffer& buffer);
-    DescriptorHandle getResourceHandle(const uuid::UUID& id);
-    void removeResourceRegistration(const uuid::UUID& id);
+    // no lookup, only checks the generation
+    DescriptorHandle getResourceHandle(DescriptorKey key) const;
+    // also resets the resource's descriptor
+    void removeResourceRegistration(Image& image);
+    void removeResourceRegistration(Buffer& buffer);
+    void removeResourceRegistration(DescriptorKey key);
+
+    static constexpr DescriptorHandle handleOf(DescriptorKey key)
+    {
+        return static_cast<DescriptorHandle>(static_cast<uint64_t>(key) & 0xffffff);
+    }
+    static constexpr DescriptorType typeOf(DescriptorKey key)
+    {
+        return static_cast<DescriptorType>((static_cast<uint64_t>(key) >> 24) & 0xff);
+    }
+    static constexpr uint32_t generationOf(DescriptorKey key)
+    {
+        return static_cast<uint32_t>(static_cast<uint64_t>(key) >> 32);
+    }
     constexpr VkDescriptorSet* BINDLESS_SET() { return &bindlessSet; }
     constexpr VkDescriptorSetLayout BINDLESS_LAYOUT() { return bindlessLayout; }
 
-    void registerParameter(const Buffer& buffer);
-    void removeParameter(const uuid::UUID& uuid);
-    VkDescriptorSet* getParameterSet(const uuid::UUID& uuid);
-    constexpr VkDescriptorSetLayout PARAMETER_LAYOUT() const { return parameterLayout; }
-
     void cleanup();
 
     static constexpr size_t MAX_UNIFORM_DESCRIPTORS = 1024;
@@ -0,0 +1,133 @@
+#include "gpu_profiler.h"
+#include "core/tool/logger.h"
+#include "core/vulkan/vulkan_context.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace Vk {
+
+void GpuProfiler::init(const Context& ctx)
+{
+    this->ctx = &ctx;
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(ctx.physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(ctx.physicalDevice, &familyCount, families.data());
+    if (families[ctx.queueFamilyIndices.graphicsFamily.value()].timestampValidBits == 0) {
+        WARN_ALL("The graphics queue doesn't support timestamps, GPU profiling is disabled");
+        return;
+    }
+
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(ctx.physicalDevice, &properties);
+    timestamp_period = properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo poolInfo {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = ctx.framesInFlight * MAX_SCOPES * 2;
+    if (vkCreateQueryPool(ctx.device, &poolInfo, nullptr, &query_pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create query pool!");
+    }
+    written.assign(ctx.framesInFlight, std::vector<bool>(MAX_SCOPES, false));
+}
+
+void GpuProfiler::destroy()
+{
+    if (query_pool != VK_NULL_HANDLE)
+        vkDestroyQueryPool(ctx->device, query_pool, nullptr);
+    query_pool = VK_NULL_HANDLE;
+}
+
+uint32_t GpuProfiler::scope(const std::string& name)
+{
+    auto it = std::find_if(scopes.begin(), scopes.end(), [&](const Timing& t) { return t.name == name; });
+    if (it != scopes.end())
+        return static_cast<uint32_t>(it - scopes.begin());
+    if (scopes.size() == MAX_SCOPES)
+        throw std::runtime_error("too many GPU profiler scopes");
+    scopes.push_back({ name });
+    return static_cast<uint32_t>(scopes.size() - 1);
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer cmd, uint32_t slot)
+{
+    if (!enabled())
+        return;
+
+    this->slot = slot;
+    collect(slot);
+    vkCmdResetQueryPool(cmd, query_pool, slot * MAX_SCOPES * 2, MAX_SCOPES * 2);
+    std::fill(written[slot].begin(), written[slot].end(), false);
+}
+
+void GpuProfiler::beginScope(VkCommandBuffer cmd, uint32_t index)
+{
+    if (!enabled())
+        return;
+
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, query_pool, (slot * MAX_SCOPES + index) * 2);
+    written[slot][index] = true;
+}
+
+void GpuProfiler::endScope(VkCommandBuffer cmd, uint32_t index)
+{
+    if (!enabled())
+        return;
+
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, query_pool, (slot * MAX_SCOPES + index) * 2 + 1);
+}
+
+void GpuProfiler::collect(uint32_t slot)
+{
+    if (std::none_of(written[slot].begin(), written[slot].end(), [](bool w) { return w; }))
+        return;
+
+    // value and availability per query, the fence of the slot signaled so
+    // everything written is available
+    std::vector<uint64_t> results(MAX_SCOPES * 2 * 2);
+    vkGetQueryPoolResults(
+        ctx->device,
+        query_pool,
+        slot * MAX_SCOPES * 2,
+        MAX_SCOPES * 2,
+        results.size() * sizeof(uint64_t),
+        results.data(),
+        2 * sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    const bool first = collected_frames == 0;
+    uint64_t frame_begin = std::numeric_limits<uint64_t>::max(), frame_end = 0;
+    for (uint32_t i = 0; i < scopes.size(); i++) {
+        const uint64_t* begin = &results[i * 4];
+        const uint64_t* end = &results[i * 4 + 2];
+        if (!written[slot][i] || begin[1] == 0 || end[1] == 0)
+            continue;
+
+        auto& timing = scopes[i];
+        timing.ms = float((end[0] - begin[0]) * timestamp_period / 1e6);
+        timing.average_ms = first ? timing.ms : 0.95f * timing.average_ms + 0.05f * timing.ms;
+        frame_begin = std::min(frame_begin, begin[0]);
+        frame_end = std::max(frame_end, end[0]);
+    }
+    if (frame_end > frame_begin) {
+        frame_ms = float((frame_end - frame_begin) * timestamp_period / 1e6);
+        frame_average_ms = first ? frame_ms : 0.95f * frame_average_ms + 0.05f * frame_ms;
+    }
+
+    if (++collected_frames % LOG_INTERVAL == 0)
+        log();
+}
+
+void GpuProfiler::log()
+{
+    // one json object per line
+    std::string line = fmt::format("{{\"frame\": {}, \"frame_ms\": {:.4f}", collected_frames, frame_ms);
+    for (const auto& timing : scopes)
+        line += fmt::format(", \"{}\": {:.4f}", timing.name, timing.average_ms);
+    line += "}";
+    INFO_FILE("gpu_timings {}", line);
+}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace Vk {
+
+struct Context;
+
+// GPU durations of named scopes from timestamp queries. Every frame slot has
+// its own range of queries, which is read back without waiting once the
+// fence of the slot signaled, i.e. framesInFlight frames later.
+class GpuProfiler {
+public:
+    static constexpr uint32_t MAX_SCOPES = 32;
+    // frames between two lines of the timing log
+    static constexpr uint32_t LOG_INTERVAL = 120;
+
+    struct Timing {
+        std::string name;
+        float ms = 0.0f;
+        // exponential moving average, steadier to read
+        float average_ms = 0.0f;
+    };
+
+    void init(const Context& ctx);
+    void destroy();
+
+    // index of the scope with the name, added if it doesn't exist yet
+    uint32_t scope(const std::string& name);
+
+    // Reads back the previous results of the slot, then resets its queries.
+    // Call first thing after beginning the frame's command buffer.
+    void beginFrame(VkCommandBuffer cmd, uint32_t slot);
+    void beginScope(VkCommandBuffer cmd, uint32_t index);
+    void endScope(VkCommandBuffer cmd, uint32_t index);
+
+    const std::vector<Timing>& timings() const { return scopes; }
+    // from the beginning of the first scope to the end of the last one
+    float frameMs() const { return frame_ms; }
+    // averaged like Timing::average_ms
+    float frameAverageMs() const { return frame_average_ms; }
+    bool enabled() const { return query_pool != VK_NULL_HANDLE; }
+
+private:
+    void collect(uint32_t slot);
+    void log();
+
+    const Context* ctx = nullptr;
+    VkQueryPool query_pool = VK_NULL_HANDLE;
+    float timestamp_period = 1.0f;
+
+    std::vector<Timing> scopes;
+    float frame_ms = 0.0f;
+    float frame_average_ms = 0.0f;
+    uint32_t slot = 0;
+    // scopes written per slot, 0 before the slot was recorded
+    std::vector<std::vector<bool>> written;
+    uint32_t collected_frames = 0;
+};
+}
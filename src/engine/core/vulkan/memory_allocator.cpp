@@ -0,0 +1,301 @@
+#include "memory_allocator.h"
+#include "core/tool/logger.h"
+#include "core/vulkan/vulkan_context.h"
+#include "core/vulkan/vulkan_util.h"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace Vk {
+void MemoryAllocator::init(const Context& ctx)
+{
+    this->ctx = &ctx;
+    vkGetPhysicalDeviceMemoryProperties(ctx.physicalDevice, &memory_properties);
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(ctx.physicalDevice, &properties);
+    allocation_limit = properties.limits.maxMemoryAllocationCount;
+    pools.resize(memory_properties.memoryTypeCount * 2);
+}
+
+void MemoryAllocator::destroy()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    uint32_t leaked = 0;
+    for (auto& pool : pools) {
+        for (auto& page : pool.pages) {
+            leaked += page.count;
+            releaseBlock(page);
+        }
+        for (auto& block : pool.blocks) {
+            leaked += block.count;
+            releaseBlock(block);
+        }
+        leaked += pool.dedicated_count;
+    }
+    pools.clear();
+    if (leaked > 0)
+        WARN_ALL("{} device memory allocations were not freed", leaked);
+}
+
+Allocation MemoryAllocator::allocate(const MemoryRequest& request)
+{
+    const auto& requirements = request.requirements;
+    uint32_t type = findMemoryType(*ctx, requirements.memoryTypeBits, request.properties);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    uint32_t pool_index = type * 2 + (request.optimal_image ? 1 : 0);
+    auto& pool = pools[pool_index];
+    Allocation allocation;
+    if (request.export_info != nullptr
+        || request.dedicated_buffer != VK_NULL_HANDLE
+        || request.dedicated_image != VK_NULL_HANDLE
+        || requirements.size >= DEDICATED_SIZE) {
+        allocation = allocateDedicated(pool, type, request);
+    } else {
+        // both are powers of two, so a slot is aligned by its size
+        VkDeviceSize slot_size = std::bit_ceil(std::max({ requirements.size, requirements.alignment, MIN_SIZE_CLASS }));
+        if (slot_size <= MAX_SIZE_CLASS)
+            allocation = allocateSizeClass(pool, type, slot_size);
+        else
+            allocation = allocateLinear(pool, type, requirements);
+    }
+    allocation.pool = pool_index;
+    return allocation;
+}
+
+MemoryAllocator::Block MemoryAllocator::newBlock(uint32_t type, VkDeviceSize size, const void* next)
+{
+    Block block;
+    block.size = size;
+
+    VkMemoryAllocateInfo allocInfo {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.pNext = next;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = type;
+    if (vkAllocateMemory(ctx->device, &allocInfo, nullptr, &block.memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate device memory!");
+    }
+    if (memory_properties.memoryTypes[type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        vkMapMemory(ctx->device, block.memory, 0, VK_WHOLE_SIZE, 0, &block.mapped);
+    return block;
+}
+
+void MemoryAllocator::releaseBlock(Block& block)
+{
+    if (block.memory != VK_NULL_HANDLE)
+        vkFreeMemory(ctx->device, block.memory, nullptr);
+    block = Block {};
+}
+
+Allocation MemoryAllocator::allocateSizeClass(Pool& pool, uint32_t type, VkDeviceSize slot_size)
+{
+    auto page = std::find_if(pool.pages.begin(), pool.pages.end(), [&](const Block& p) {
+        return p.slot_size == slot_size && !p.free_slots.empty();
+    });
+    if (page == pool.pages.end()) {
+        // an empty page of any size class is cut into slots again
+        page = std::find_if(pool.pages.begin(), pool.pages.end(), [](const Block& p) {
+            return p.count == 0;
+        });
+        if (page == pool.pages.end())
+            page = pool.pages.emplace(pool.pages.end());
+        if (page->memory == VK_NULL_HANDLE)
+            *page = newBlock(type, PAGE_SIZE);
+        page->slot_size = slot_size;
+        page->free_slots.clear();
+        for (VkDeviceSize offset = PAGE_SIZE; offset >= slot_size; offset -= slot_size)
+            page->free_slots.emplace_back(offset - slot_size);
+    }
+
+    Allocation allocation;
+    allocation.strategy = AllocationStrategy::SizeClass;
+    allocation.memory = page->memory;
+    allocation.offset = page->free_slots.back();
+    allocation.size = slot_size;
+    allocation.block = static_cast<uint32_t>(page - pool.pages.begin());
+    if (page->mapped != nullptr)
+        allocation.mapped = static_cast<char*>(page->mapped) + allocation.offset;
+    page->free_slots.pop_back();
+    page->count++;
+    return allocation;
+}
+
+Allocation MemoryAllocator::allocateLinear(Pool& pool, uint32_t type, const VkMemoryRequirements& requirements)
+{
+    auto aligned = [&](const Block& b) {
+        return (b.head + requirements.alignment - 1) / requirements.alignment * requirements.alignment;
+    };
+    auto block = std::find_if(pool.blocks.begin(), pool.blocks.end(), [&](const Block& b) {
+        return b.memory != VK_NULL_HANDLE && aligned(b) + requirements.size <= b.size;
+    });
+    if (block == pool.blocks.end()) {
+        block = std::find_if(pool.blocks.begin(), pool.blocks.end(), [](const Block& b) {
+            return b.memory == VK_NULL_HANDLE;
+        });
+        if (block == pool.blocks.end())
+            block = pool.blocks.emplace(pool.blocks.end());
+        *block = newBlock(type, BLOCK_SIZE);
+    }
+
+    Allocation allocation;
+    allocation.strategy = AllocationStrategy::Linear;
+    allocation.memory = block->memory;
+    allocation.offset = aligned(*block);
+    allocation.size = requirements.size;
+    allocation.block = static_cast<uint32_t>(block - pool.blocks.begin());
+    if (block->mapped != nullptr)
+        allocation.mapped = static_cast<char*>(block->mapped) + allocation.offset;
+    block->head = allocation.offset + allocation.size;
+    block->live += allocation.size;
+    block->count++;
+    return allocation;
+}
+
+Allocation MemoryAllocator::allocateDedicated(Pool& pool, uint32_t type, const MemoryRequest& request)
+{
+    // exported memory is imported by CUDA as a whole and without the
+    // dedicated flag, so it never carries a dedicated allocate info
+    VkMemoryDedicatedAllocateInfo dedicatedInfo {};
+    dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicatedInfo.buffer = request.dedicated_buffer;
+    dedicatedInfo.image = request.dedicated_image;
+    const void* next = request.export_info;
+    if (next == nullptr && (request.dedicated_buffer != VK_NULL_HANDLE || request.dedicated_image != VK_NULL_HANDLE))
+        next = &dedicatedInfo;
+
+    Block block = newBlock(type, request.requirements.size, next);
+    pool.dedicated_count++;
+    pool.dedicated_size += block.size;
+
+    Allocation allocation;
+    allocation.strategy = AllocationStrategy::Dedicated;
+    allocation.memory = block.memory;
+    allocation.size = block.size;
+    allocation.mapped = block.mapped;
+    return allocation;
+}
+
+void MemoryAllocator::free(Allocation& allocation)
+{
+    if (allocation.strategy == AllocationStrategy::None)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& pool = pools[allocation.pool];
+    switch (allocation.strategy) {
+    case AllocationStrategy::SizeClass: {
+        auto& page = pool.pages[allocation.block];
+        page.free_slots.emplace_back(allocation.offset);
+        page.count--;
+        break;
+    }
+    case AllocationStrategy::Linear: {
+        auto& block = pool.blocks[allocation.block];
+        block.live -= allocation.size;
+        if (--block.count == 0)
+            block.head = 0;
+        break;
+    }
+    case AllocationStrategy::Dedicated:
+        vkFreeMemory(ctx->device, allocation.memory, nullptr);
+        pool.dedicated_count--;
+        pool.dedicated_size -= allocation.size;
+        break;
+    default:
+        break;
+    }
+    allocation = Allocation {};
+}
+
+std::vector<VkDeviceMemory> MemoryAllocator::fragmentedBlocks(float max_usage) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<VkDeviceMemory> fragmented;
+    for (const auto& pool : pools) {
+        for (const auto& block : pool.blocks) {
+            if (block.count > 0 && block.live < block.head * max_usage)
+                fragmented.emplace_back(block.memory);
+        }
+    }
+    return fragmented;
+}
+
+void MemoryAllocator::trim()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& pool : pools) {
+        for (auto& page : pool.pages) {
+            if (page.count == 0)
+                releaseBlock(page);
+        }
+        for (auto& block : pool.blocks) {
+            if (block.count == 0)
+                releaseBlock(block);
+        }
+    }
+}
+
+MemoryStats MemoryAllocator::poolStats(const Pool& pool)
+{
+    MemoryStats stats;
+    stats.device_allocations = pool.dedicated_count;
+    stats.allocations = pool.dedicated_count;
+    stats.reserved = pool.dedicated_size;
+    stats.used = pool.dedicated_size;
+    for (const auto& page : pool.pages) {
+        if (page.memory == VK_NULL_HANDLE)
+            continue;
+        stats.device_allocations++;
+        stats.allocations += page.count;
+        stats.reserved += page.size;
+        stats.used += page.count * page.slot_size;
+    }
+    for (const auto& block : pool.blocks) {
+        if (block.memory == VK_NULL_HANDLE)
+            continue;
+        stats.device_allocations++;
+        stats.allocations += block.count;
+        stats.reserved += block.size;
+        stats.used += block.live;
+    }
+    return stats;
+}
+
+MemoryStats MemoryAllocator::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    MemoryStats total;
+    for (const auto& pool : pools) {
+        auto stats = poolStats(pool);
+        total.device_allocations += stats.device_allocations;
+        total.allocations += stats.allocations;
+        total.reserved += stats.reserved;
+        total.used += stats.used;
+    }
+    return total;
+}
+
+void MemoryAllocator::dumpStats() const
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (uint32_t i = 0; i < pools.size(); i++) {
+            const auto& pool = pools[i];
+            auto stats = poolStats(pool);
+            if (stats.device_allocations == 0)
+                continue;
+            size_t pages = std::count_if(pool.pages.begin(), pool.pages.end(), [](const Block& p) { return p.memory != VK_NULL_HANDLE; });
+            size_t blocks = std::count_if(pool.blocks.begin(), pool.blocks.end(), [](const Block& b) { return b.memory != VK_NULL_HANDLE; });
+            INFO_ALL("Memory type {} {}: {} allocations, {:.1f} of {:.1f} MB used, {} pages, {} blocks, {} dedicated",
+                i / 2, i % 2 ? "images" : "buffers", stats.allocations,
+                stats.used / 1048576.0, stats.reserved / 1048576.0,
+                pages, blocks, pool.dedicated_count);
+        }
+    }
+    auto total = stats();
+    INFO_ALL("Device memory: {} allocations in {} of at most {} device allocations, {:.1f} of {:.1f} MB used",
+        total.allocations, total.device_allocations, allocation_limit,
+        total.used / 1048576.0, total.reserved / 1048576.0);
+}
+}
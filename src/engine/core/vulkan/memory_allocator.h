@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace Vk {
+
+struct Context;
+
+enum class AllocationStrategy : uint8_t {
+    None,
+    // equally sized power of two slots of a shared page
+    SizeClass,
+    // bump allocated from a shared block, which is reused once it is empty
+    Linear,
+    // memory of its own
+    Dedicated,
+};
+
+struct Allocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    // address of offset if the memory is host visible
+    void* mapped = nullptr;
+    AllocationStrategy strategy = AllocationStrategy::None;
+    uint32_t pool = 0;
+    uint32_t block = 0;
+};
+
+struct MemoryRequest {
+    VkMemoryRequirements requirements;
+    VkMemoryPropertyFlags properties;
+    // optimal tiling images never share a page or block with buffers and
+    // linear images, so bufferImageGranularity doesn't matter
+    bool optimal_image = false;
+    // export info chained into the allocation, always dedicated
+    const void* export_info = nullptr;
+    // set if the driver prefers a dedicated allocation for the resource
+    VkBuffer dedicated_buffer = VK_NULL_HANDLE;
+    VkImage dedicated_image = VK_NULL_HANDLE;
+};
+
+struct MemoryStats {
+    uint32_t device_allocations = 0;
+    uint32_t allocations = 0;
+    // bytes of device memory allocated and bytes handed out of it
+    VkDeviceSize reserved = 0;
+    VkDeviceSize used = 0;
+};
+
+// Sub-allocates device memory for buffers and images, so most resources no
+// longer cost a vkAllocateMemory each. Every memory type has two pools, one
+// for buffers and linear images and one for optimal images:
+// - requests up to MAX_SIZE_CLASS take a slot of a page of their size class
+// - larger ones are bump allocated from a linear block
+// - requests of at least DEDICATED_SIZE, exported ones and those the driver
+//   asks for get their own memory
+// Host visible pages and blocks are mapped persistently.
+class MemoryAllocator {
+public:
+    static constexpr VkDeviceSize MIN_SIZE_CLASS = 256;
+    static constexpr VkDeviceSize MAX_SIZE_CLASS = 256 << 10;
+    static constexpr VkDeviceSize PAGE_SIZE = 4 << 20;
+    static constexpr VkDeviceSize BLOCK_SIZE = 64 << 20;
+    static constexpr VkDeviceSize DEDICATED_SIZE = 16 << 20;
+
+    void init(const Context& ctx);
+    // frees all memory, the remaining allocations are reported as leaked
+    void destroy();
+
+    Allocation allocate(const MemoryRequest& request);
+    void free(Allocation& allocation);
+
+    // Defragmentation hook: linear blocks in which less than max_usage of the
+    // bump allocated range is still alive. Their owners can recreate the
+    // resources with allocation.memory in the list, the block is reused as
+    // soon as the last one is freed.
+    std::vector<VkDeviceMemory> fragmentedBlocks(float max_usage = 0.5f) const;
+    // frees pages and blocks that are empty, they are kept for reuse otherwise
+    void trim();
+
+    MemoryStats stats() const;
+    // logs the stats of every pool in use
+    void dumpStats() const;
+
+private:
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+        VkDeviceSize size = 0;
+        uint32_t count = 0;
+        // Linear: bump head and bytes still alive below it
+        VkDeviceSize head = 0;
+        VkDeviceSize live = 0;
+        // SizeClass: slot size and offsets of the free slots
+        VkDeviceSize slot_size = 0;
+        std::vector<VkDeviceSize> free_slots;
+    };
+    struct Pool {
+        std::vector<Block> pages;
+        std::vector<Block> blocks;
+        uint32_t dedicated_count = 0;
+        VkDeviceSize dedicated_size = 0;
+    };
+
+    Allocation allocateSizeClass(Pool& pool, uint32_t type, VkDeviceSize slot_size);
+    Allocation allocateLinear(Pool& pool, uint32_t type, const VkMemoryRequirements& requirements);
+    Allocation allocateDedicated(Pool& pool, uint32_t type, const MemoryRequest& request);
+    Block newBlock(uint32_t type, VkDeviceSize size, const void* next = nullptr);
+    void releaseBlock(Block& block);
+    static MemoryStats poolStats(const Pool& pool);
+
+    const Context* ctx = nullptr;
+    VkPhysicalDeviceMemoryProperties memory_properties {};
+    uint32_t allocation_limit = 0;
+    mutable std::mutex mutex;
+    // memory type * 2 + optimal_image
+    std::vector<Pool> pools;
+};
+}
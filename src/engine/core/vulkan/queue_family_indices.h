@@ -9,6 +9,8 @@ namespace Vk {
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    // a family that transfers but can't render, i.e. a separate copy engine
+    std::optional<uint32_t> transferFamily;
 
     static QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface)
     {
@@ -19,18 +21,32 @@ struct QueueFamilyIndices {
         std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
         vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
+        // prefer a transfer only family over one that can compute as well
+        bool transferOnly = false;
         int i = 0;
         for (const auto& queueFamily : queueFamilies) {
             if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
                 indices.graphicsFamily = i;
 
-            // if it can render to the surface we created
+            // if it can render to the surface we created, without one the
+            // graphics queue "presents" by leaving the image for readback
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+            if (surface != VK_NULL_HANDLE)
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+            else
+                presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
             if (presentSupport) {
                 indices.presentFamily = i;
             }
 
+            if ((queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+                bool only = !(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT);
+                if (!indices.transferFamily.has_value() || (only && !transferOnly)) {
+                    indices.transferFamily = i;
+                    transferOnly = only;
+                }
+            }
+
             i++;
         }
         return indices;
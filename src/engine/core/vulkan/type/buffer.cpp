@@ -18,10 +18,13 @@ Buffer Buffer::New(const Vk::Context& ctx,
     Buffer b;
     b.CreateUUID();
     b.size = size;
-    createBuffer(ctx, size, usage, properties, b.buffer, b.memory, external);
+    createBuffer(ctx, size, usage, properties, b.buffer, b.allocation, external);
     b.mapped = nullptr;
-    if (cpu_mapped)
-        vkMapMemory(ctx.device, b.memory, 0, size, 0, &b.mapped);
+    if (cpu_mapped) {
+        if (b.allocation.mapped == nullptr)
+            throw std::runtime_error("cpu mapped buffer must be host visible");
+        b.mapped = b.allocation.mapped;
+    }
     b.usage = usage;
     return b;
 }
@@ -32,40 +35,24 @@ void Buffer::CreateUUID()
     id = uuid::newUUID();
 }
 
-void Buffer::Update(const Context& ctx, const void* data, size_t size, size_t offset)
+UploadTicket Buffer::Update(const Context& ctx, const void* data, size_t size, size_t offset)
 {
     if (size + offset > this->size)
         throw std::runtime_error("buffer overflow");
 
     if (mapped != nullptr) {
         memcpy((char*)mapped + offset, data, size);
-        return;
+        return 0;
     }
 
     if ((usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) == 0) {
         throw std::runtime_error("buffer must be created with VK_BUFFER_USAGE_TRANSFER_DST_BIT");
     }
 
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_buffer_memory;
-    createBuffer(
-        ctx,
-        size,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        staging_buffer, staging_buffer_memory, true);
-    void* mapped_data;
-    vkMapMemory(ctx.device, staging_buffer_memory, 0, size, 0, &mapped_data);
-    memcpy(mapped_data, data, size);
-    vkUnmapMemory(ctx.device, staging_buffer_memory);
-
-    copyBufferSingleTime(ctx, staging_buffer, buffer, size, 0, offset);
-
-    vkDestroyBuffer(ctx.device, staging_buffer, nullptr);
-    vkFreeMemory(ctx.device, staging_buffer_memory, nullptr);
+    return ctx.uploader->upload(*this, data, size, offset);
 }
 
-void Buffer::CopyToSingleTime(
+UploadTicket Buffer::CopyToSingleTime(
     const Context& ctx,
     Buffer& dst,
     size_t size,
@@ -75,10 +62,13 @@ void Buffer::CopyToSingleTime(
     if (size + srcOffset > this->size || size + dstOffset > dst.size)
         throw std::runtime_error("buffer overflow");
 
-    copyBufferSingleTime(ctx, dst.buffer, buffer, size, srcOffset, dstOffset);
+    dst.initialized = true;
+    return ctx.uploader->record([&](VkCommandBuffer cmd) {
+        copyBuffer(cmd, buffer, dst.buffer, size, srcOffset, dstOffset);
+    });
 }
 
-void Buffer::CopyToSingleTime(
+UploadTicket Buffer::CopyToSingleTime(
     const Context& ctx,
     Image& dst,
     const VkExtent3D& extent,
@@ -91,19 +81,21 @@ void Buffer::CopyToSingleTime(
         || dstOffset.z + extent.depth > dst.extent.depth)
         throw std::runtime_error("image overflow");
 
-    copyBufferToImageSingleTime(
-        ctx,
-        buffer,
-        dst.image,
-        dst.layout,
-        dst.format,
-        extent,
-        mipLevel,
-        dstOffset,
-        srcOffset);
+    return ctx.uploader->record([&](VkCommandBuffer cmd) {
+        copyBufferToImage(
+            cmd,
+            buffer,
+            dst.image,
+            dst.layout,
+            dst.format,
+            extent,
+            mipLevel,
+            dstOffset,
+            srcOffset);
+    });
 }
 
-void Buffer::CopyTo(
+UploadTicket Buffer::CopyTo(
     const Context& ctx,
     Image& dst,
     const VkExtent3D& extent,
@@ -116,16 +108,18 @@ void Buffer::CopyTo(
         || dstOffset.z + extent.depth > dst.extent.depth)
         throw std::runtime_error("image overflow");
 
-    copyBufferToImageSingleTime(
-        ctx,
-        buffer,
-        dst.image,
-        dst.layout,
-        dst.format,
-        extent,
-        mipLevel,
-        dstOffset,
-        srcOffset);
+    return ctx.uploader->record([&](VkCommandBuffer cmd) {
+        copyBufferToImage(
+            cmd,
+            buffer,
+            dst.image,
+            dst.layout,
+            dst.format,
+            extent,
+            mipLevel,
+            dstOffset,
+            srcOffset);
+    });
 }
 
 void Buffer::CopyTo(
@@ -144,5 +138,5 @@ void Buffer::CopyTo(
 void Buffer::Delete(const Context& ctx, Buffer& b)
 {
     vkDestroyBuffer(ctx.device, b.buffer, nullptr);
-    vkFreeMemory(ctx.device, b.memory, nullptr);
+    ctx.allocator->free(b.allocation);
 }
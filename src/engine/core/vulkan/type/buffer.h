@@ -1,6 +1,9 @@
 #pragma once
 
 #include "core/tool/uuid.h"
+#include "core/vulkan/descriptor_key.h"
+#include "core/vulkan/memory_allocator.h"
+#include "core/vulkan/upload_manager.h"
 #include <vulkan/vulkan_core.h>
 
 namespace Vk {
@@ -19,29 +22,31 @@ struct Buffer {
         bool external = false);
     static void Delete(const Vk::Context& ctx, Buffer& b);
     void CreateUUID();
-    void Update(const Context& ctx, const void* data, size_t size, size_t offset = 0);
+    // queued on the upload manager unless the buffer is cpu mapped
+    UploadTicket Update(const Context& ctx, const void* data, size_t size, size_t offset = 0);
     void CopyTo(
         const Context& ctx,
         Buffer& dst,
         size_t size,
         size_t srcOffset = 0,
         size_t dstOffset = 0) const;
-    void CopyTo(
+    // queued on the upload manager like CopyToSingleTime
+    UploadTicket CopyTo(
         const Context& ctx,
         Image& dst,
         const VkExtent3D& extent,
         uint32_t mipLevel = 0,
         size_t srcOffset = 0,
         const VkOffset3D& dstOffset = { 0, 0, 0 }) const;
-    // No need to submit command buffer
-    void CopyToSingleTime(
+    // Queued on the upload manager, wait for the ticket before reading dst
+    // on the host
+    UploadTicket CopyToSingleTime(
         const Context& ctx,
         Buffer& dst,
         size_t size,
         size_t srcOffset = 0,
         size_t dstOffset = 0) const;
-    // No need to submit command buffer
-    void CopyToSingleTime(
+    UploadTicket CopyToSingleTime(
         const Context& ctx,
         Image& dst,
         const VkExtent3D& extent,
@@ -50,10 +55,15 @@ struct Buffer {
         const VkOffset3D& dstOffset = { 0, 0, 0 }) const;
 
     uuid::UUID id = uuid::nil_uuid();
+    // set while the buffer is registered with the descriptor manager
+    DescriptorKey descriptor = DescriptorKey::Null;
     VkBuffer buffer;
-    VkDeviceMemory memory;
+    Allocation allocation;
     void* mapped = nullptr;
     VkBufferUsageFlags usage;
     size_t size = 0;
+    // false until the first upload, no frame can have used the contents yet
+    // so that upload may run on the transfer queue
+    bool initialized = false;
 };
 }
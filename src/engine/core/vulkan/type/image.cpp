@@ -21,7 +21,7 @@ Image Image::New(const Context& ctx,
 {
     Image i;
     i.CreateUUID();
-    i.size = createImage(ctx, extent, format, usage, properties, i.image, i.memory, external, tiling, imageType, mipLevels);
+    i.size = createImage(ctx, extent, format, usage, properties, i.image, i.allocation, external, tiling, imageType, mipLevels);
     i.view = createImageView(ctx, i.image, format, aspectFlags, viewType, mipLevels);
     i.format = format;
     i.extent = extent;
@@ -42,10 +42,13 @@ void Image::TransitionLayout(const Context& ctx, VkImageLayout newLayout)
     layout = newLayout;
 }
 
-void Image::TransitionLayoutSingleTime(const Context& ctx, VkImageLayout newLayout)
+UploadTicket Image::TransitionLayoutSingleTime(const Context& ctx, VkImageLayout newLayout)
 {
-    transitionImageLayoutSingleTime(ctx, image, format, layout, newLayout);
+    auto ticket = ctx.uploader->record([&](VkCommandBuffer cmd) {
+        transitionImageLayout(cmd, image, format, layout, newLayout);
+    });
     layout = newLayout;
+    return ticket;
 }
 
 void Image::AddDefaultSampler(const Context& ctx)
@@ -82,28 +85,9 @@ void Image::AddSampler(const Context& ctx, const VkFilter filter, const std::vec
     }
 }
 
-void Image::Update(const Context& ctx, const void* data, uint32_t mipLevel)
+UploadTicket Image::Update(const Context& ctx, const void* data, uint32_t mipLevel)
 {
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_buffer_memory;
-    createBuffer(
-        ctx,
-        size,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        staging_buffer, staging_buffer_memory, true);
-    void* mapped_data;
-    vkMapMemory(ctx.device, staging_buffer_memory, 0, size, 0, &mapped_data);
-    memcpy(mapped_data, data, size);
-    vkUnmapMemory(ctx.device, staging_buffer_memory);
-
-    if (layout == VK_IMAGE_LAYOUT_UNDEFINED) {
-        TransitionLayoutSingleTime(ctx, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    }
-    copyBufferToImageSingleTime(ctx, staging_buffer, image, layout, format, extent, mipLevel);
-
-    vkDestroyBuffer(ctx.device, staging_buffer, nullptr);
-    vkFreeMemory(ctx.device, staging_buffer_memory, nullptr);
+    return ctx.uploader->upload(*this, data, size, mipLevel);
 }
 
 void Image::CopyTo(
@@ -165,7 +149,7 @@ void Image::CopyTo(
         dstOffset);
 }
 
-void Image::CopyToSingleTime(
+UploadTicket Image::CopyToSingleTime(
     const Context& ctx,
     Image& dst,
     const VkExtent3D& extent,
@@ -184,22 +168,24 @@ void Image::CopyToSingleTime(
         || dstOffset.z + extent.depth > dst.extent.depth)
         throw std::runtime_error("image overflow");
 
-    copyImageToImageSingleTime(
-        ctx,
-        image,
-        dst.image,
-        layout,
-        dst.layout,
-        format,
-        dst.format,
-        extent,
-        srcMipLevel,
-        dstMipLevel,
-        srcOffset,
-        dstOffset);
+    return ctx.uploader->record([&](VkCommandBuffer cmd) {
+        copyImageToImage(
+            cmd,
+            image,
+            dst.image,
+            layout,
+            dst.layout,
+            format,
+            dst.format,
+            extent,
+            srcMipLevel,
+            dstMipLevel,
+            srcOffset,
+            dstOffset);
+    });
 }
 
-void Image::CopyToSingleTime(
+UploadTicket Image::CopyToSingleTime(
     const Context& ctx,
     Buffer& dst,
     const VkExtent3D& extent,
@@ -212,23 +198,25 @@ void Image::CopyToSingleTime(
         || srcOffset.z + extent.depth > this->extent.depth)
         throw std::runtime_error("image overflow");
 
-    copyImageToBuffer(
-        ctx.commandBuffer,
-        image,
-        dst.buffer,
-        layout,
-        format,
-        extent,
-        mipLevel,
-        srcOffset,
-        dstOffset);
+    return ctx.uploader->record([&](VkCommandBuffer cmd) {
+        copyImageToBuffer(
+            cmd,
+            image,
+            dst.buffer,
+            layout,
+            format,
+            extent,
+            mipLevel,
+            srcOffset,
+            dstOffset);
+    });
 }
 
 void Image::Delete(const Context& ctx, Image& i)
 {
     vkDestroyImageView(ctx.device, i.view, nullptr);
     vkDestroyImage(ctx.device, i.image, nullptr);
-    vkFreeMemory(ctx.device, i.memory, nullptr);
+    ctx.allocator->free(i.allocation);
     if (i.sampler != VK_NULL_HANDLE)
         vkDestroySampler(ctx.device, i.sampler, nullptr);
 }
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "core/tool/uuid.h"
+#include "core/vulkan/descriptor_key.h"
+#include "core/vulkan/memory_allocator.h"
+#include "core/vulkan/upload_manager.h"
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
@@ -28,9 +31,11 @@ struct Image {
     void CreateUUID();
     void AddSampler(const Context& ctx, const VkFilter filter, const std::vector<VkSamplerAddressMode>& addressMode, const VkBorderColor borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK);
     void AddDefaultSampler(const Context& ctx);
-    void Update(const Context& ctx, const void* data, uint32_t mipLevel = 0);
+    // Update, TransitionLayoutSingleTime and CopyToSingleTime are queued on the
+    // upload manager, layout changes immediately on the host
+    UploadTicket Update(const Context& ctx, const void* data, uint32_t mipLevel = 0);
     void TransitionLayout(const Context& ctx, VkImageLayout newLayout);
-    void TransitionLayoutSingleTime(const Context& ctx, VkImageLayout newLayout);
+    UploadTicket TransitionLayoutSingleTime(const Context& ctx, VkImageLayout newLayout);
     void CopyTo(
         const Context& ctx,
         Image& dst,
@@ -46,8 +51,7 @@ struct Image {
         uint32_t mipLevel = 0,
         const VkOffset3D& srcOffset = { 0, 0, 0 },
         size_t dstOffset = 0) const;
-    // No need to submit command buffer
-    void CopyToSingleTime(
+    UploadTicket CopyToSingleTime(
         const Context& ctx,
         Image& dst,
         const VkExtent3D& extent,
@@ -55,8 +59,7 @@ struct Image {
         uint32_t dstMipLevel = 0,
         const VkOffset3D& srcOffset = { 0, 0, 0 },
         const VkOffset3D& dstOffset = { 0, 0, 0 }) const;
-    // No need to submit command buffer
-    void CopyToSingleTime(
+    UploadTicket CopyToSingleTime(
         const Context& ctx,
         Buffer& dst,
         const VkExtent3D& extent,
@@ -65,9 +68,11 @@ struct Image {
         size_t dstOffset = 0) const;
 
     uuid::UUID id = uuid::nil_uuid();
+    // set while the image is registered with the descriptor manager
+    DescriptorKey descriptor = DescriptorKey::Null;
     VkImage image;
     VkImageView view;
-    VkDeviceMemory memory;
+    Allocation allocation;
     VkExtent3D extent;
     VkFormat format;
     VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
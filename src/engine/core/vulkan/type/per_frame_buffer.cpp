@@ -0,0 +1,49 @@
+#include "per_frame_buffer.h"
+#include "core/vulkan/vulkan_context.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace Vk;
+
+PerFrameBuffer PerFrameBuffer::New(const Context& ctx, VkDeviceSize size, VkBufferUsageFlags usage)
+{
+    PerFrameBuffer b;
+    b.shadow.resize(size);
+    b.buffers.resize(ctx.framesInFlight);
+    for (auto& buffer : b.buffers) {
+        buffer = Buffer::New(
+            ctx,
+            size,
+            usage,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            true);
+    }
+    return b;
+}
+
+void PerFrameBuffer::Delete(const Context& ctx, PerFrameBuffer& b)
+{
+    for (auto& buffer : b.buffers)
+        Buffer::Delete(ctx, buffer);
+    b.buffers.clear();
+    b.shadow.clear();
+    b.stale_mask = 0;
+}
+
+void PerFrameBuffer::Update(const void* data, size_t size, size_t offset)
+{
+    if (size + offset > shadow.size())
+        throw std::runtime_error("buffer overflow");
+
+    memcpy(shadow.data() + offset, data, size);
+    stale_mask = (1u << buffers.size()) - 1;
+}
+
+void PerFrameBuffer::Flush(uint32_t slot)
+{
+    if ((stale_mask & (1u << slot)) == 0)
+        return;
+
+    memcpy(buffers[slot].mapped, shadow.data(), shadow.size());
+    stale_mask &= ~(1u << slot);
+}
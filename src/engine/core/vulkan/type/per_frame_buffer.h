@@ -0,0 +1,31 @@
+#pragma once
+
+#include "buffer.h"
+#include <cstdint>
+#include <vector>
+
+namespace Vk {
+struct Context;
+
+// Host written buffer with one persistently mapped copy per frame in flight.
+// Update only writes a host side copy; Flush(slot) brings the copy read by
+// the frame in that slot up to date and must only be called while the GPU
+// is not using it, i.e. between its fence wait and the submit.
+struct PerFrameBuffer {
+    static PerFrameBuffer New(const Context& ctx, VkDeviceSize size, VkBufferUsageFlags usage);
+    static void Delete(const Context& ctx, PerFrameBuffer& b);
+    void Update(const void* data, size_t size, size_t offset = 0);
+    void Flush(uint32_t slot);
+
+    Buffer& operator[](uint32_t slot) { return buffers[slot]; }
+    const Buffer& operator[](uint32_t slot) const { return buffers[slot]; }
+    size_t size() const { return shadow.size(); }
+
+    std::vector<Buffer> buffers;
+
+private:
+    std::vector<uint8_t> shadow;
+    // bit i is set while buffers[i] is behind shadow
+    uint32_t stale_mask = 0;
+};
+}
@@ -0,0 +1,106 @@
+#include "uniform_ring.h"
+#include "core/vulkan/vulkan_context.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace Vk {
+void UniformRing::init(const Context& ctx)
+{
+    this->ctx = &ctx;
+
+    VkPhysicalDeviceProperties properties {};
+    vkGetPhysicalDeviceProperties(ctx.physicalDevice, &properties);
+    alignment = properties.limits.minUniformBufferOffsetAlignment;
+
+    // the last parameter of the last slot still needs a whole range behind it
+    buffer = Buffer::New(
+        ctx,
+        FRAME_CAPACITY * ctx.framesInFlight + MAX_RANGE,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+
+    VkDescriptorSetLayoutBinding layoutBinding = {};
+    layoutBinding.binding = 0;
+    layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    layoutBinding.descriptorCount = 1;
+    layoutBinding.stageFlags = VK_SHADER_STAGE_ALL;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &layoutBinding;
+    if (vkCreateDescriptorSetLayout(ctx.device, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+
+    VkDescriptorPoolSize poolSize {};
+    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    poolSize.descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo poolInfo {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = 1;
+    if (vkCreateDescriptorPool(ctx.device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+    if (vkAllocateDescriptorSets(ctx.device, &allocInfo, &set) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate descriptor sets!");
+    }
+
+    VkDescriptorBufferInfo bufferInfo {};
+    bufferInfo.buffer = buffer.buffer;
+    bufferInfo.offset = 0;
+    bufferInfo.range = MAX_RANGE;
+
+    VkWriteDescriptorSet descriptorWrite {};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = set;
+    descriptorWrite.dstBinding = 0;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    descriptorWrite.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(ctx.device, 1, &descriptorWrite, 0, nullptr);
+}
+
+void UniformRing::beginFrame(uint32_t slot)
+{
+    frame_begin = FRAME_CAPACITY * slot;
+    head.store(0, std::memory_order_relaxed);
+}
+
+uint32_t UniformRing::push(const void* data, size_t size)
+{
+    // the descriptor only covers MAX_RANGE bytes behind the offset
+    if (size > MAX_RANGE)
+        throw std::runtime_error("uniform ring push exceeds the bound range!");
+    const VkDeviceSize aligned = (size + alignment - 1) / alignment * alignment;
+    const VkDeviceSize offset = head.fetch_add(aligned, std::memory_order_relaxed);
+    if (offset + aligned > FRAME_CAPACITY)
+        throw std::runtime_error("uniform ring is full!");
+
+    memcpy(static_cast<char*>(buffer.mapped) + frame_begin + offset, data, size);
+    return static_cast<uint32_t>(frame_begin + offset);
+}
+
+void UniformRing::bind(VkCommandBuffer cmd, VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32_t index, uint32_t offset) const
+{
+    vkCmdBindDescriptorSets(cmd, bind_point, layout, index, 1, &set, 1, &offset);
+}
+
+void UniformRing::destroy()
+{
+    vkDestroyDescriptorSetLayout(ctx->device, layout, nullptr);
+    vkDestroyDescriptorPool(ctx->device, pool, nullptr);
+    Buffer::Delete(*ctx, buffer);
+}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "core/vulkan/type/buffer.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace Vk {
+
+struct Context;
+
+// Per frame parameters of pipelines and draws. Every frame slot owns a region
+// of one persistently mapped buffer, parameters are bump allocated in it and
+// bound through a single UNIFORM_BUFFER_DYNAMIC descriptor with their offset.
+// The region of a slot is reused once its fence signaled.
+class UniformRing {
+public:
+    // bytes per frame slot
+    static constexpr VkDeviceSize FRAME_CAPACITY = 1 << 18;
+    // range of the descriptor, the largest parameter block a shader reads
+    static constexpr VkDeviceSize MAX_RANGE = 1024;
+
+    void init(const Context& ctx);
+    void destroy();
+
+    // call after the fence of slot was waited on
+    void beginFrame(uint32_t slot);
+    // copies data into the current slot's region and returns its dynamic
+    // offset, safe to call from the recording threads
+    uint32_t push(const void* data, size_t size);
+    // binds the parameters as set index of layout
+    void bind(VkCommandBuffer cmd, VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32_t index, uint32_t offset) const;
+
+    constexpr VkDescriptorSetLayout LAYOUT() const { return layout; }
+
+private:
+    const Context* ctx = nullptr;
+    Buffer buffer;
+    VkDeviceSize alignment = 256;
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+
+    VkDeviceSize frame_begin = 0;
+    std::atomic<VkDeviceSize> head = 0;
+};
+}
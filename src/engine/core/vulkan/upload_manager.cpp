@@ -0,0 +1,396 @@
+#include "upload_manager.h"
+#include "core/tool/logger.h"
+#include "core/vulkan/type/buffer.h"
+#include "core/vulkan/type/image.h"
+#include "core/vulkan/vulkan_context.h"
+#include "core/vulkan/vulkan_util.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace Vk {
+namespace {
+    // orders the batch against everything submitted before and after it
+    void fullBarrier(VkCommandBuffer cmd)
+    {
+        VkMemoryBarrier barrier {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+        vkCmdPipelineBarrier(
+            cmd,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr);
+    }
+}
+
+void UploadManager::init(const Context& ctx)
+{
+    this->ctx = &ctx;
+
+    initLane(graphics, ctx.queue, ctx.queueFamilyIndices.graphicsFamily.value());
+    use_transfer = ctx.queueFamilyIndices.transferFamily.has_value();
+    if (!use_transfer)
+        return;
+
+    initLane(transfer, ctx.transferQueue, ctx.queueFamilyIndices.transferFamily.value());
+    VkSemaphoreTypeCreateInfo semaphoreTypeInfo {};
+    semaphoreTypeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    semaphoreTypeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    semaphoreTypeInfo.initialValue = 0;
+    VkSemaphoreCreateInfo semaphoreInfo {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &semaphoreTypeInfo;
+    if (vkCreateSemaphore(ctx.device, &semaphoreInfo, nullptr, &transfer_timeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create semaphore!");
+    }
+    INFO_ALL("Uploads use the transfer queue family {}", transfer.family);
+}
+
+void UploadManager::initLane(Lane& lane, VkQueue queue, uint32_t family)
+{
+    lane.queue = queue;
+    lane.family = family;
+
+    createBuffer(
+        *ctx,
+        RING_SIZE,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        lane.ring, lane.ring_allocation);
+
+    for (auto& batch : lane.batches) {
+        VkCommandPoolCreateInfo poolInfo {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = family;
+        if (vkCreateCommandPool(ctx->device, &poolInfo, nullptr, &batch.pool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create command pool!");
+        }
+
+        VkCommandBufferAllocateInfo allocInfo {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = batch.pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(ctx->device, &allocInfo, &batch.cmd) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate command buffers!");
+        }
+
+        VkFenceCreateInfo fenceInfo {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        if (vkCreateFence(ctx->device, &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create fence!");
+        }
+    }
+}
+
+void UploadManager::destroy()
+{
+    flush();
+    destroyLane(graphics);
+    if (use_transfer) {
+        destroyLane(transfer);
+        vkDestroySemaphore(ctx->device, transfer_timeline, nullptr);
+    }
+}
+
+void UploadManager::destroyLane(Lane& lane)
+{
+    for (auto& batch : lane.batches) {
+        vkDestroyFence(ctx->device, batch.fence, nullptr);
+        vkDestroyCommandPool(ctx->device, batch.pool, nullptr);
+    }
+    vkDestroyBuffer(ctx->device, lane.ring, nullptr);
+    ctx->allocator->free(lane.ring_allocation);
+}
+
+UploadManager::Batch& UploadManager::openBatch(Lane& lane)
+{
+    if (lane.open != BATCH_COUNT)
+        return lane.batches[lane.open];
+
+    retireFinished(lane);
+    if (lane.in_flight.size() == BATCH_COUNT)
+        retireOldest(lane);
+    uint32_t index = 0;
+    while (std::find(lane.in_flight.begin(), lane.in_flight.end(), index) != lane.in_flight.end())
+        index++;
+
+    auto& batch = lane.batches[index];
+    vkResetCommandPool(ctx->device, batch.pool, 0);
+    VkCommandBufferBeginInfo beginInfo {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(batch.cmd, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording command buffer!");
+    }
+    fullBarrier(batch.cmd);
+    batch.ticket = lane.next_ticket++;
+    batch.staged = 0;
+    lane.open = index;
+    return batch;
+}
+
+std::pair<VkBuffer, VkDeviceSize> UploadManager::stage(Lane& lane, const void* data, size_t size)
+{
+    if (size > MAX_RING_UPLOAD) {
+        auto& batch = openBatch(lane);
+        VkBuffer buffer;
+        Allocation allocation;
+        createBuffer(
+            *ctx,
+            size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            buffer, allocation);
+        memcpy(allocation.mapped, data, size);
+        batch.staging.emplace_back(buffer, allocation);
+        batch.staged += size;
+        return { buffer, 0 };
+    }
+
+    // 16 covers the texel size of every format copied to images
+    const VkDeviceSize aligned = (size + 15) & ~VkDeviceSize(15);
+    VkDeviceSize offset = lane.head % RING_SIZE;
+    if (offset + aligned > RING_SIZE) {
+        lane.head += RING_SIZE - offset;
+        offset = 0;
+    }
+    while (lane.head + aligned - lane.tail > RING_SIZE) {
+        if (lane.in_flight.empty()) {
+            if (lane.open == BATCH_COUNT) {
+                lane.tail = lane.head;
+                break;
+            }
+            submitBatch(lane);
+        }
+        retireOldest(lane);
+    }
+
+    memcpy(static_cast<char*>(lane.ring_allocation.mapped) + offset, data, size);
+    lane.head += aligned;
+    openBatch(lane).staged += size;
+    return { lane.ring, offset };
+}
+
+void UploadManager::submitBatch(Lane& lane)
+{
+    // the acquires recorded into a graphics batch need their releases submitted
+    const bool is_graphics = &lane == &graphics;
+    if (is_graphics && use_transfer && transfer.open != BATCH_COUNT)
+        submitBatch(transfer);
+
+    auto& batch = lane.batches[lane.open];
+    fullBarrier(batch.cmd);
+    if (vkEndCommandBuffer(batch.cmd) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+
+    VkSubmitInfo submitInfo {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.cmd;
+
+    const uint64_t transfer_value = is_graphics ? transfer.next_ticket - 1 : batch.ticket;
+    const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    VkTimelineSemaphoreSubmitInfo timelineInfo {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    if (!is_graphics) {
+        timelineInfo.signalSemaphoreValueCount = 1;
+        timelineInfo.pSignalSemaphoreValues = &transfer_value;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &transfer_timeline;
+    } else if (use_transfer && transfer_value > 0) {
+        timelineInfo.waitSemaphoreValueCount = 1;
+        timelineInfo.pWaitSemaphoreValues = &transfer_value;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &transfer_timeline;
+        submitInfo.pWaitDstStageMask = &waitStage;
+    }
+
+    vkResetFences(ctx->device, 1, &batch.fence);
+    if (vkQueueSubmit(lane.queue, 1, &submitInfo, batch.fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit upload command buffer!");
+    }
+
+    batch.ring_end = lane.head;
+    lane.in_flight.emplace_back(lane.open);
+    lane.open = BATCH_COUNT;
+}
+
+void UploadManager::retireOldest(Lane& lane)
+{
+    auto& batch = lane.batches[lane.in_flight.front()];
+    vkWaitForFences(ctx->device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+
+    lane.tail = batch.ring_end;
+    for (auto& [buffer, allocation] : batch.staging) {
+        vkDestroyBuffer(ctx->device, buffer, nullptr);
+        ctx->allocator->free(allocation);
+    }
+    batch.staging.clear();
+    lane.finished_ticket = batch.ticket;
+    lane.in_flight.pop_front();
+}
+
+void UploadManager::retireFinished(Lane& lane)
+{
+    while (!lane.in_flight.empty() && vkGetFenceStatus(ctx->device, lane.batches[lane.in_flight.front()].fence) == VK_SUCCESS)
+        retireOldest(lane);
+}
+
+UploadTicket UploadManager::upload(Buffer& dst, const void* data, size_t size, size_t offset)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const bool fresh = !dst.initialized;
+    dst.initialized = true;
+
+    if (!use_transfer || !fresh) {
+        auto [src, src_offset] = stage(graphics, data, size);
+        auto& batch = openBatch(graphics);
+        copyBuffer(batch.cmd, src, dst.buffer, size, src_offset, offset);
+        return batch.ticket;
+    }
+
+    auto [src, src_offset] = stage(transfer, data, size);
+    auto& batch = openBatch(transfer);
+    copyBuffer(batch.cmd, src, dst.buffer, size, src_offset, offset);
+
+    // release on the transfer queue, acquire with the same barrier on the
+    // graphics queue
+    VkBufferMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.srcQueueFamilyIndex = transfer.family;
+    barrier.dstQueueFamilyIndex = graphics.family;
+    barrier.buffer = dst.buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(batch.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    auto& acquire = openBatch(graphics);
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    vkCmdPipelineBarrier(acquire.cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    if (batch.staged >= TRANSFER_SUBMIT_SIZE)
+        submitBatch(transfer);
+    return acquire.ticket;
+}
+
+UploadTicket UploadManager::upload(Image& dst, const void* data, size_t size, uint32_t mipLevel)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const bool fresh = dst.layout == VK_IMAGE_LAYOUT_UNDEFINED;
+    const VkImageLayout layout = fresh ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : dst.layout;
+
+    if (!use_transfer || !fresh) {
+        auto [src, src_offset] = stage(graphics, data, size);
+        auto& batch = openBatch(graphics);
+        if (fresh)
+            transitionImageLayout(batch.cmd, dst.image, dst.format, dst.layout, layout);
+        copyBufferToImage(batch.cmd, src, dst.image, layout, dst.format, dst.extent, mipLevel, { 0, 0, 0 }, src_offset);
+        dst.layout = layout;
+        return batch.ticket;
+    }
+
+    auto [src, src_offset] = stage(transfer, data, size);
+    auto& batch = openBatch(transfer);
+
+    // the contents are undefined, so the transfer queue takes the image
+    // without an acquire
+    VkImageMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = dst.image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(batch.cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkBufferImageCopy region {};
+    region.bufferOffset = src_offset;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = mipLevel;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = dst.extent;
+    vkCmdCopyBufferToImage(batch.cmd, src, dst.image, layout, 1, &region);
+
+    barrier.oldLayout = layout;
+    barrier.srcQueueFamilyIndex = transfer.family;
+    barrier.dstQueueFamilyIndex = graphics.family;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    vkCmdPipelineBarrier(batch.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    auto& acquire = openBatch(graphics);
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    vkCmdPipelineBarrier(acquire.cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    if (batch.staged >= TRANSFER_SUBMIT_SIZE)
+        submitBatch(transfer);
+    dst.layout = layout;
+    return acquire.ticket;
+}
+
+UploadTicket UploadManager::record(const std::function<void(VkCommandBuffer)>& fn)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& batch = openBatch(graphics);
+    fn(batch.cmd);
+    return batch.ticket;
+}
+
+UploadTicket UploadManager::submit()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (graphics.open != BATCH_COUNT)
+        submitBatch(graphics);
+    return graphics.next_ticket - 1;
+}
+
+bool UploadManager::finished(UploadTicket ticket)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    retireFinished(graphics);
+    if (use_transfer)
+        retireFinished(transfer);
+    return ticket <= graphics.finished_ticket;
+}
+
+void UploadManager::wait(UploadTicket ticket)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (graphics.open != BATCH_COUNT && graphics.batches[graphics.open].ticket <= ticket)
+        submitBatch(graphics);
+    while (graphics.finished_ticket < ticket && !graphics.in_flight.empty())
+        retireOldest(graphics);
+}
+
+void UploadManager::flush()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (graphics.open != BATCH_COUNT)
+        submitBatch(graphics);
+    while (!graphics.in_flight.empty())
+        retireOldest(graphics);
+    if (use_transfer) {
+        while (!transfer.in_flight.empty())
+            retireOldest(transfer);
+    }
+}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "core/vulkan/memory_allocator.h"
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace Vk {
+
+struct Context;
+struct Buffer;
+struct Image;
+
+// identifies the batch a transfer was queued in, 0 is always finished
+using UploadTicket = uint64_t;
+
+// Batches uploads, copies and layout transitions into one command buffer
+// that is submitted to the graphics queue in front of the next frame or on
+// submit(). Data is copied into a persistently mapped staging ring right
+// away, the ring space is reclaimed when the batch's fence signaled.
+// Every batch starts and ends with a full barrier, so it is ordered against
+// all submissions before and after it without the caller waiting.
+//
+// With a dedicated transfer queue family, uploads to buffers that were never
+// written and to images in the undefined layout are copied on the transfer
+// queue instead and released to the graphics family. The graphics batch
+// acquires them after waiting for the transfer batch. The copies overlap
+// the frames still in flight, only the next frame waits for them.
+class UploadManager {
+public:
+    static constexpr VkDeviceSize RING_SIZE = 64 << 20;
+    // larger uploads get a staging buffer of their own
+    static constexpr VkDeviceSize MAX_RING_UPLOAD = RING_SIZE / 4;
+    static constexpr uint32_t BATCH_COUNT = 4;
+    // a transfer batch holding this much is submitted right away, so the
+    // copies start while the caller keeps loading
+    static constexpr VkDeviceSize TRANSFER_SUBMIT_SIZE = 8 << 20;
+
+    void init(const Context& ctx);
+    // waits for all batches
+    void destroy();
+
+    UploadTicket upload(Buffer& dst, const void* data, size_t size, size_t offset = 0);
+    // an undefined dst is left in TRANSFER_DST_OPTIMAL, otherwise dst keeps
+    // its layout
+    UploadTicket upload(Image& dst, const void* data, size_t size, uint32_t mipLevel = 0);
+    // records fn into the open graphics batch right away
+    UploadTicket record(const std::function<void(VkCommandBuffer)>& fn);
+
+    // submits the open batches, if any, and returns the ticket of the last one
+    UploadTicket submit();
+    bool finished(UploadTicket ticket);
+    // submits the batch of ticket if it is still open
+    void wait(UploadTicket ticket);
+    // submits and waits for everything queued
+    void flush();
+
+private:
+    struct Batch {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        UploadTicket ticket = 0;
+        // bytes copied for the batch so far
+        VkDeviceSize staged = 0;
+        // ring position behind the batch's last upload
+        VkDeviceSize ring_end = 0;
+        // staging buffers of uploads too large for the ring
+        std::vector<std::pair<VkBuffer, Allocation>> staging;
+    };
+    // a queue with its own staging ring and batches, which retire in
+    // submission order
+    struct Lane {
+        VkQueue queue = VK_NULL_HANDLE;
+        uint32_t family = 0;
+
+        VkBuffer ring = VK_NULL_HANDLE;
+        Allocation ring_allocation;
+        // monotonic byte positions, the ring offset is the position % RING_SIZE
+        VkDeviceSize head = 0;
+        VkDeviceSize tail = 0;
+
+        std::array<Batch, BATCH_COUNT> batches;
+        // index of the batch recording, BATCH_COUNT if none is
+        uint32_t open = BATCH_COUNT;
+        // indices of the submitted batches, oldest first
+        std::deque<uint32_t> in_flight;
+        UploadTicket next_ticket = 1;
+        UploadTicket finished_ticket = 0;
+    };
+
+    void initLane(Lane& lane, VkQueue queue, uint32_t family);
+    void destroyLane(Lane& lane);
+    Batch& openBatch(Lane& lane);
+    // returns the staging buffer and offset data was copied to
+    std::pair<VkBuffer, VkDeviceSize> stage(Lane& lane, const void* data, size_t size);
+    void submitBatch(Lane& lane);
+    void retireOldest(Lane& lane);
+    void retireFinished(Lane& lane);
+
+    const Context* ctx = nullptr;
+    std::mutex mutex;
+
+    // its tickets are the ones handed out
+    Lane graphics;
+    // only used with a dedicated transfer queue family
+    Lane transfer;
+    bool use_transfer = false;
+    // signaled with the ticket of every transfer batch, each graphics batch
+    // waits for the transfer batches submitted before it
+    VkSemaphore transfer_timeline = VK_NULL_HANDLE;
+};
+}
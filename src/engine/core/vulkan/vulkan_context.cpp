@@ -1,8 +1,12 @@
 #include "vulkan_context.h"
+#include "core/vulkan/memory_allocator.h"
 #include "core/vulkan/swapchain_support.h"
+#include "core/vulkan/upload_manager.h"
 #include "core/vulkan/type/image.h"
 #include "core/vulkan/vulkan_util.h"
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstring>
 #include <set>
 
 namespace Vk {
@@ -12,33 +16,56 @@ Context::~Context() = default;
 void Context::init(const Configuration& config, GLFWwindow* window)
 {
     this->window = window;
+    headless = config.headless.enabled;
+    WIDTH = config.width;
+    HEIGHT = config.height;
+    if (headless) {
+        outputLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        std::erase_if(deviceExtensions, [](const char* extension) {
+            return strcmp(extension, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0;
+        });
+    }
+    // the step of frame n writes the field images frame n - 1 renders from,
+    // unless they are double buffered, with two buffers it may only overlap
+    // the render of frame n
+    const uint32_t maxDepth = config.frame_pipeline.double_buffered_fields ? 2u : 1u;
+    pipelineDepth = std::clamp(config.frame_pipeline.depth, 1u, maxDepth);
+    if (config.frame_pipeline.depth > maxDepth)
+        WARN_ALL("Frame pipeline depth {} needs more field buffers, using {}", config.frame_pipeline.depth, pipelineDepth);
+    framesInFlight = std::clamp(config.frame_pipeline.frames_in_flight, 1u, 8u);
 
     initVulkan();
 }
 
 void Context::cleanup()
 {
+    uploader->destroy();
     vkDestroySemaphore(device, cuUpdateSemaphore, nullptr);
     vkDestroySemaphore(device, vkUpdateSemaphore, nullptr);
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (size_t i = 0; i < framesInFlight; i++) {
         vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
         vkDestroyFence(device, inFlightFences[i], nullptr);
+        vkDestroyCommandPool(device, frameCommandPools[i], nullptr);
     }
 
     vkDestroyCommandPool(device, commandPool, nullptr);
 
     cleanupSwapChain();
+    allocator->destroy();
 
-    vkDestroySurfaceKHR(instance, surface, nullptr);
+    if (!headless)
+        vkDestroySurfaceKHR(instance, surface, nullptr);
     vkDestroyDevice(device, nullptr);
 #ifdef DEBUG
     debugMessager.destroy(*this);
 #endif
     vkDestroyInstance(instance, nullptr);
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (window != nullptr) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 }
 
 void Context::createInstance()
@@ -55,10 +82,13 @@ void Context::createInstance()
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.apiVersion = VK_API_VERSION_1_2;
 
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-    std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    std::vector<const char*> extensions;
+    if (!headless) {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
     for (const auto& e : instanceExtensions)
         extensions.push_back(e);
 
@@ -161,6 +191,13 @@ bool Context::isDeviceSuitable(VkPhysicalDevice device)
 
     bool extensionsSupported = checkDeviceExtensionSupport(device);
 
+    // software implementations report a CPU device type and have no surface
+    if (headless) {
+        return deviceFeatures.samplerAnisotropy
+            && indices.isComplete()
+            && extensionsSupported;
+    }
+
     bool swapChainAdequate = false;
     if (extensionsSupported) {
         SwapChainSupport swapChainSupport = SwapChainSupport::querySwapChainSupport(device, surface);
@@ -203,6 +240,8 @@ void Context::createLogicalDeviceAndQueue()
 {
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = { queueFamilyIndices.graphicsFamily.value(), queueFamilyIndices.presentFamily.value() };
+    if (queueFamilyIndices.transferFamily.has_value())
+        uniqueQueueFamilies.insert(queueFamilyIndices.transferFamily.value());
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -214,9 +253,13 @@ void Context::createLogicalDeviceAndQueue()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures {};
+    timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    timelineSemaphoreFeatures.pNext = nullptr;
+
     VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures {};
     descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
-    descriptorIndexingFeatures.pNext = nullptr;
+    descriptorIndexingFeatures.pNext = &timelineSemaphoreFeatures;
 
     VkPhysicalDeviceFeatures2 deviceFeatures {};
     deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
@@ -228,6 +271,8 @@ void Context::createLogicalDeviceAndQueue()
     assert(descriptorIndexingFeatures.descriptorBindingUniformBufferUpdateAfterBind);
     assert(descriptorIndexingFeatures.shaderStorageBufferArrayNonUniformIndexing);
     assert(descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind);
+    assert(descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending);
+    assert(timelineSemaphoreFeatures.timelineSemaphore);
 
     VkDeviceCreateInfo createInfo {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -243,6 +288,8 @@ void Context::createLogicalDeviceAndQueue()
 
     vkGetDeviceQueue(device, queueFamilyIndices.graphicsFamily.value(), 0, &queue);
     vkGetDeviceQueue(device, queueFamilyIndices.presentFamily.value(), 0, &presentQueue);
+    if (queueFamilyIndices.transferFamily.has_value())
+        vkGetDeviceQueue(device, queueFamilyIndices.transferFamily.value(), 0, &transferQueue);
 }
 
 void Context::createSurface()
@@ -357,8 +404,29 @@ void Context::createSwapChainImageViews()
     }
 }
 
+void Context::createOffscreenImages()
+{
+    for (uint32_t i = 0; i < framesInFlight; i++) {
+        swapChainImages.emplace_back(std::make_unique<Image>(Image::New(
+            *this,
+            VK_FORMAT_B8G8R8A8_UNORM,
+            VkExtent3D { WIDTH, HEIGHT, 1 },
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+        swapChainImages.back()->TransitionLayoutSingleTime(*this, outputLayout);
+    }
+}
+
 void Context::cleanupSwapChain()
 {
+    if (headless) {
+        for (auto& image : swapChainImages)
+            Image::Delete(*this, *image);
+        swapChainImages.clear();
+        return;
+    }
+
     for (auto& swapChainImage : swapChainImages) {
         vkDestroyImageView(device, swapChainImage->view, nullptr);
         swapChainImage.reset(nullptr);
@@ -371,6 +439,10 @@ void Context::recreateSwapChain()
 {
     cleanupSwapChain();
 
+    if (headless) {
+        createOffscreenImages();
+        return;
+    }
     createSwapChain();
     createSwapChainImageViews();
 }
@@ -385,15 +457,26 @@ void Context::createCommandPoolAndBuffer()
         throw std::runtime_error("failed to create command pool!");
     }
 
-    VkCommandBufferAllocateInfo allocInfo {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = commandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = (uint32_t)MAX_FRAMES_IN_FLIGHT;
+    // frame pools are reset with vkResetCommandPool instead of per buffer
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    frameCommandPools.resize(framesInFlight);
+    frameCommandBuffers.resize(framesInFlight);
+    for (uint32_t i = 0; i < framesInFlight; i++) {
+        if (vkCreateCommandPool(device, &poolInfo, nullptr, &frameCommandPools[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create command pool!");
+        }
+
+        VkCommandBufferAllocateInfo allocInfo {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = frameCommandPools[i];
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
 
-    if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate command buffers!");
+        if (vkAllocateCommandBuffers(device, &allocInfo, &frameCommandBuffers[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate command buffers!");
+        }
     }
+    commandBuffer = frameCommandBuffers[0];
 }
 
 void Context::initVulkan()
@@ -402,14 +485,23 @@ void Context::initVulkan()
 #ifdef DEBUG
     debugMessager.init(*this);
 #endif
-    createSurface();
+    if (!headless)
+        createSurface();
     pickPhysicalDevice();
     queueFamilyIndices = QueueFamilyIndices::findQueueFamilies(physicalDevice, surface);
     createLogicalDeviceAndQueue();
+    allocator = std::make_unique<MemoryAllocator>();
+    allocator->init(*this);
     createCommandPoolAndBuffer();
+    uploader = std::make_unique<UploadManager>();
+    uploader->init(*this);
 
-    createSwapChain();
-    createSwapChainImageViews();
+    if (headless) {
+        createOffscreenImages();
+    } else {
+        createSwapChain();
+        createSwapChainImageViews();
+    }
 
     createSyncObjects();
     createSyncObjectsExt();
@@ -417,9 +509,9 @@ void Context::initVulkan()
 
 void Context::createSyncObjects()
 {
-    imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+    imageAvailableSemaphores.resize(framesInFlight);
+    renderFinishedSemaphores.resize(framesInFlight);
+    inFlightFences.resize(framesInFlight);
 
     VkSemaphoreCreateInfo semaphoreInfo {};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -428,7 +520,7 @@ void Context::createSyncObjects()
     fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (size_t i = 0; i < framesInFlight; i++) {
         if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS || vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS || vkCreateFence(device, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
             throw std::runtime_error("failed to create synchronization objects for a frame!");
         }
@@ -451,12 +543,18 @@ void Context::createSyncObjectsExt()
     memset(&semaphoreInfo, 0, sizeof(semaphoreInfo));
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
+    VkSemaphoreTypeCreateInfo semaphoreTypeInfo = {};
+    semaphoreTypeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    semaphoreTypeInfo.pNext = NULL;
+    semaphoreTypeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    semaphoreTypeInfo.initialValue = 0;
+
 #ifdef _WIN64
     WindowsSecurityAttributes winSecurityAttributes;
 
     VkExportSemaphoreWin32HandleInfoKHR vulkanExportSemaphoreWin32HandleInfoKHR = {};
     vulkanExportSemaphoreWin32HandleInfoKHR.sType = VK_STRUCTURE_TYPE_EXPORT_SEMAPHORE_WIN32_HANDLE_INFO_KHR;
-    vulkanExportSemaphoreWin32HandleInfoKHR.pNext = NULL;
+    vulkanExportSemaphoreWin32HandleInfoKHR.pNext = &semaphoreTypeInfo;
     vulkanExportSemaphoreWin32HandleInfoKHR.pAttributes = &winSecurityAttributes;
     vulkanExportSemaphoreWin32HandleInfoKHR.dwAccess = DXGI_SHARED_RESOURCE_READ | DXGI_SHARED_RESOURCE_WRITE;
     vulkanExportSemaphoreWin32HandleInfoKHR.name = (LPCWSTR)NULL;
@@ -469,7 +567,7 @@ void Context::createSyncObjectsExt()
     vulkanExportSemaphoreCreateInfo.pNext = &vulkanExportSemaphoreWin32HandleInfoKHR;
     vulkanExportSemaphoreCreateInfo.handleTypes = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_WIN32_BIT;
 #else
-    vulkanExportSemaphoreCreateInfo.pNext = NULL;
+    vulkanExportSemaphoreCreateInfo.pNext = &semaphoreTypeInfo;
     vulkanExportSemaphoreCreateInfo.handleTypes = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD_BIT;
 #endif
 
@@ -4,6 +4,7 @@
 #include "core/tool/logger.h"
 #include "core/vulkan/debug_messager.h"
 #include "core/vulkan/queue_family_indices.h"
+#include <memory>
 #include <vulkan/vulkan.h>
 
 #ifdef _WIN64
@@ -14,6 +15,8 @@ class GLFWwindow;
 
 namespace Vk {
 struct Image;
+class MemoryAllocator;
+class UploadManager;
 
 struct Context {
     Context();
@@ -24,24 +27,48 @@ struct Context {
     void cleanup();
 
     GLFWwindow* window;
+    // no window, surface or swapchain: swapChainImages are offscreen images
+    // owned by the context, one per frame in flight
+    bool headless = false;
+    // layout swapChainImages are left in at the end of a frame
+    VkImageLayout outputLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
     VkInstance instance;
     VkPhysicalDevice physicalDevice;
     VkDevice device;
     DebugMessager debugMessager;
+    // backs every Buffer and Image
+    std::unique_ptr<MemoryAllocator> allocator;
 
+    // single time commands
     VkCommandPool commandPool;
+    // Every frame in flight records into its own pool, which is reset as a
+    // whole once the fence of that frame signaled. commandBuffer is the one
+    // of the frame currently being recorded.
+    uint32_t framesInFlight = 1;
+    std::vector<VkCommandPool> frameCommandPools;
+    std::vector<VkCommandBuffer> frameCommandBuffers;
     VkCommandBuffer commandBuffer;
+    // uploads and transfers outside of frames, replaces single time commands
+    std::unique_ptr<UploadManager> uploader;
 
     VkQueue queue;
     VkQueue presentQueue;
+    // only set if queueFamilyIndices has a transfer family
+    VkQueue transferQueue = VK_NULL_HANDLE;
     QueueFamilyIndices queueFamilyIndices;
 
-    VkSurfaceKHR surface;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
 
     VkSwapchainKHR swapChain;
     std::vector<std::unique_ptr<Image>> swapChainImages;
 
+    // Timeline semaphores shared with CUDA, keyed by frame number. Rendering
+    // frame n signals vkUpdateSemaphore with n + 1 and waits for
+    // cuUpdateSemaphore >= n, i.e. the physics step of frame n - 1.
+    // The physics step of frame n signals cuUpdateSemaphore with n + 1 and
+    // waits for the render of frame n + 1 - pipelineDepth.
     VkSemaphore cuUpdateSemaphore, vkUpdateSemaphore;
+    uint32_t pipelineDepth = 1;
     std::vector<VkSemaphore> imageAvailableSemaphores;
     std::vector<VkSemaphore> renderFinishedSemaphores;
     std::vector<VkFence> inFlightFences;
@@ -70,6 +97,7 @@ private:
     VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
     void createSwapChain();
     void createSwapChainImageViews();
+    void createOffscreenImages();
     void cleanupSwapChain();
 
     void createCommandPoolAndBuffer();
@@ -79,8 +107,6 @@ private:
 
     uint32_t WIDTH = 800;
     uint32_t HEIGHT = 600;
-    const int MAX_FRAMES_IN_FLIGHT = 1;
-    uint32_t currentFrame = 0;
 
     const std::vector<const char*> instanceExtensions = {
 #ifdef DEBUG
@@ -89,7 +115,7 @@ private:
 #endif
     };
 
-    const std::vector<const char*> deviceExtensions = {
+    std::vector<const char*> deviceExtensions = {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 
         VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME,
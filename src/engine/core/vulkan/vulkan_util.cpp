@@ -38,38 +38,6 @@ uint32_t findMemoryType(const Context& ctx, uint32_t typeFilter, VkMemoryPropert
     throw std::runtime_error("failed to find suitable memory type!");
 }
 
-void singleTimeCommands(const Context& ctx, const std::function<void(const VkCommandBuffer&)>& fn)
-{
-    VkCommandBufferAllocateInfo allocInfo {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = ctx.commandPool;
-    allocInfo.commandBufferCount = 1;
-
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(ctx.device, &allocInfo, &commandBuffer);
-
-    VkCommandBufferBeginInfo beginInfo {};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-    fn(commandBuffer);
-
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    vkQueueSubmit(ctx.queue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(ctx.queue);
-
-    vkFreeCommandBuffers(ctx.device, ctx.commandPool, 1, &commandBuffer);
-}
-
 VkDeviceSize createImage(
     const Context& ctx,
     const VkExtent3D& extent,
@@ -77,7 +45,7 @@ VkDeviceSize createImage(
     VkImageUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkImage& image,
-    VkDeviceMemory& imageMemory,
+    Allocation& allocation,
     bool external,
     const VkImageTiling tiling,
     const VkImageType imageType,
@@ -129,23 +97,31 @@ VkDeviceSize createImage(
     exportMemoryInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
 #endif
 
-    VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements(ctx.device, image, &memRequirements);
-
-    VkMemoryAllocateInfo allocInfo {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(ctx, memRequirements.memoryTypeBits, properties);
+    VkMemoryDedicatedRequirements dedicatedRequirements {};
+    dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+    VkMemoryRequirements2 memRequirements {};
+    memRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    memRequirements.pNext = &dedicatedRequirements;
+    VkImageMemoryRequirementsInfo2 requirementsInfo {};
+    requirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+    requirementsInfo.image = image;
+    vkGetImageMemoryRequirements2(ctx.device, &requirementsInfo, &memRequirements);
+
+    MemoryRequest request {};
+    request.requirements = memRequirements.memoryRequirements;
+    request.properties = properties;
+    request.optimal_image = tiling == VK_IMAGE_TILING_OPTIMAL;
     if (external)
-        allocInfo.pNext = &exportMemoryInfo;
+        request.export_info = &exportMemoryInfo;
+    if (dedicatedRequirements.prefersDedicatedAllocation)
+        request.dedicated_image = image;
+    allocation = ctx.allocator->allocate(request);
 
-    if (vkAllocateMemory(ctx.device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate image memory!");
+    if (vkBindImageMemory(ctx.device, image, allocation.memory, allocation.offset) != VK_SUCCESS) {
+        throw std::runtime_error("failed to bind image memory!");
     }
 
-    vkBindImageMemory(ctx.device, image, imageMemory, 0);
-
-    return memRequirements.size;
+    return memRequirements.memoryRequirements.size;
 }
 
 VkImageView createImageView(
@@ -181,7 +157,7 @@ void createBuffer(
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer& buffer,
-    VkDeviceMemory& bufferMemory,
+    Allocation& allocation,
     bool external)
 {
     VkExternalMemoryBufferCreateInfo externalBufferInfo = {};
@@ -224,32 +200,28 @@ void createBuffer(
     }
 
     // memory
-    VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(ctx.device, buffer, &memRequirements);
-
-    VkMemoryAllocateInfo allocInfo {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(ctx, memRequirements.memoryTypeBits, properties);
+    VkMemoryDedicatedRequirements dedicatedRequirements {};
+    dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+    VkMemoryRequirements2 memRequirements {};
+    memRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    memRequirements.pNext = &dedicatedRequirements;
+    VkBufferMemoryRequirementsInfo2 requirementsInfo {};
+    requirementsInfo.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+    requirementsInfo.buffer = buffer;
+    vkGetBufferMemoryRequirements2(ctx.device, &requirementsInfo, &memRequirements);
+
+    MemoryRequest request {};
+    request.requirements = memRequirements.memoryRequirements;
+    request.properties = properties;
     if (external)
-        allocInfo.pNext = &exportMemoryInfo;
-    if (vkAllocateMemory(ctx.device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate vertex buffer memory!");
-    }
-    vkBindBufferMemory(ctx.device, buffer, bufferMemory, 0);
-}
+        request.export_info = &exportMemoryInfo;
+    if (dedicatedRequirements.prefersDedicatedAllocation)
+        request.dedicated_buffer = buffer;
+    allocation = ctx.allocator->allocate(request);
 
-void copyBufferSingleTime(
-    const Context& ctx,
-    VkBuffer srcBuffer,
-    VkBuffer dstBuffer,
-    VkDeviceSize size,
-    VkDeviceSize srcOffset,
-    VkDeviceSize dstOffset)
-{
-    singleTimeCommands(ctx, [&](const VkCommandBuffer& commandBuffer) {
-        copyBuffer(commandBuffer, srcBuffer, dstBuffer, size, srcOffset, dstOffset);
-    });
+    if (vkBindBufferMemory(ctx.device, buffer, allocation.memory, allocation.offset) != VK_SUCCESS) {
+        throw std::runtime_error("failed to bind buffer memory!");
+    }
 }
 
 void copyBuffer(
@@ -311,7 +283,7 @@ static std::unordered_map<VkImageLayout, LayoutDependency> layoutDependencies =
     { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
         LayoutDependency {
             VK_ACCESS_SHADER_READ_BIT,
-            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT } },
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT } },
 
     { VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
         LayoutDependency {
@@ -324,14 +296,16 @@ static std::unordered_map<VkImageLayout, LayoutDependency> layoutDependencies =
             VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT } },
 };
 
-void transitionImageLayout(
-    VkCommandBuffer commandBuffer,
+void imageLayoutBarrier(
     VkImage image,
     VkFormat format,
     VkImageLayout oldLayout,
-    VkImageLayout newLayout)
+    VkImageLayout newLayout,
+    VkImageMemoryBarrier& barrier,
+    VkPipelineStageFlags& srcStage,
+    VkPipelineStageFlags& dstStage)
 {
-    VkImageMemoryBarrier barrier {};
+    barrier = {};
     barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     barrier.oldLayout = oldLayout;
     barrier.newLayout = newLayout;
@@ -367,26 +341,28 @@ void transitionImageLayout(
         throw std::runtime_error("Unsupported new layout");
     barrier.srcAccessMask |= sourceDependency->second.access;
     barrier.dstAccessMask |= destinationDependency->second.access;
-    vkCmdPipelineBarrier(
-        commandBuffer,
-        sourceDependency->second.stage,
-        destinationDependency->second.stage,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &barrier);
+    srcStage = sourceDependency->second.stage;
+    dstStage = destinationDependency->second.stage;
 }
 
-void transitionImageLayoutSingleTime(
-    const Vk::Context& ctx,
+void transitionImageLayout(
+    VkCommandBuffer commandBuffer,
     VkImage image,
     VkFormat format,
     VkImageLayout oldLayout,
     VkImageLayout newLayout)
 {
-    singleTimeCommands(ctx, [&](const VkCommandBuffer& commandBuffer) {
-        transitionImageLayout(commandBuffer, image, format, oldLayout, newLayout);
-    });
+    VkImageMemoryBarrier barrier;
+    VkPipelineStageFlags srcStage, dstStage;
+    imageLayoutBarrier(image, format, oldLayout, newLayout, barrier, srcStage, dstStage);
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        srcStage,
+        dstStage,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &barrier);
 }
 
 void copyBufferToImage(
@@ -437,22 +413,6 @@ void copyBufferToImage(
         imageLayout);
 }
 
-void copyBufferToImageSingleTime(
-    const Context& ctx,
-    VkBuffer buffer,
-    VkImage image,
-    VkImageLayout imageLayout,
-    VkFormat format,
-    const VkExtent3D& extent,
-    const uint32_t mipLevel,
-    const VkOffset3D& imageOffset,
-    const VkDeviceSize& bufferOffset)
-{
-    singleTimeCommands(ctx, [&](const VkCommandBuffer& commandBuffer) {
-        copyBufferToImage(commandBuffer, buffer, image, imageLayout, format, extent, mipLevel, imageOffset, bufferOffset);
-    });
-}
-
 void copyImageToBuffer(
     VkCommandBuffer commandBuffer,
     VkImage image,
@@ -481,7 +441,8 @@ void copyImageToBuffer(
     region.imageSubresource.layerCount = 1;
     region.imageOffset = imageOffset;
     region.imageExtent = extent;
-    if (imageLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL || imageLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
+    if (imageLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL || imageLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+        || format == VK_FORMAT_D32_SFLOAT)
         region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
 
     vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
@@ -493,22 +454,6 @@ void copyImageToBuffer(
         imageLayout);
 }
 
-void copyImageToBufferSingleTime(
-    const Context& ctx,
-    VkImage image,
-    VkBuffer buffer,
-    VkImageLayout imageLayout,
-    VkFormat format,
-    const VkExtent3D& extent,
-    const uint32_t mipLevel,
-    const VkOffset3D& imageOffset,
-    const VkDeviceSize& bufferOffset)
-{
-    singleTimeCommands(ctx, [&](const VkCommandBuffer& commandBuffer) {
-        copyImageToBuffer(commandBuffer, image, buffer, imageLayout, format, extent, mipLevel, imageOffset, bufferOffset);
-    });
-}
-
 void copyImageToImage(
     VkCommandBuffer commandBuffer,
     VkImage src,
@@ -569,25 +514,6 @@ void copyImageToImage(
         dstLayout);
 }
 
-void copyImageToImageSingleTime(
-    const Context& ctx,
-    VkImage src,
-    VkImage dst,
-    VkImageLayout srcLayout,
-    VkImageLayout dstLayout,
-    VkFormat srcFormat,
-    VkFormat dstFormat,
-    const VkExtent3D& extent,
-    const uint32_t srcMipLevel,
-    const uint32_t dstMipLevel,
-    const VkOffset3D& srcOffset,
-    const VkOffset3D& dstOffset)
-{
-    singleTimeCommands(ctx, [&](const VkCommandBuffer& commandBuffer) {
-        copyImageToImage(commandBuffer, src, dst, srcLayout, dstLayout, srcFormat, dstFormat, extent, srcMipLevel, dstMipLevel, srcOffset, dstOffset);
-    });
-}
-
 VkShaderModule createShaderModule(const Context& ctx, const std::vector<char>& code)
 {
     VkShaderModuleCreateInfo createInfo {};
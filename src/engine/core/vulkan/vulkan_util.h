@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <filesystem>
 #include <functional>
+#include "core/vulkan/memory_allocator.h"
 #include <glm/glm.hpp>
 #include <string>
 #include <vulkan/vulkan.h>
@@ -28,17 +29,13 @@ uint32_t findMemoryType(
     uint32_t typeFilter,
     VkMemoryPropertyFlags properties);
 
-void singleTimeCommands(
-    const Vk::Context& ctx,
-    const std::function<void(const VkCommandBuffer&)>& fn);
-
 void createBuffer(
     const Vk::Context& ctx,
     VkDeviceSize size,
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer& buffer,
-    VkDeviceMemory& bufferMemory,
+    Allocation& allocation,
     bool external = false);
 
 void copyBuffer(
@@ -48,13 +45,6 @@ void copyBuffer(
     VkDeviceSize size,
     VkDeviceSize srcOffset = 0,
     VkDeviceSize dstOffset = 0);
-void copyBufferSingleTime(
-    const Context& ctx,
-    VkBuffer srcBuffer,
-    VkBuffer dstBuffer,
-    VkDeviceSize size,
-    VkDeviceSize srcOffset = 0,
-    VkDeviceSize dstOffset = 0);
 
 VkDeviceSize createImage(
     const Context& ctx,
@@ -63,7 +53,7 @@ VkDeviceSize createImage(
     VkImageUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkImage& image,
-    VkDeviceMemory& imageMemory,
+    Allocation& allocation,
     bool external = false,
     const VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL,
     const VkImageType imageType = VK_IMAGE_TYPE_2D,
@@ -76,14 +66,17 @@ VkImageView createImageView(
     VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D,
     const uint32_t mipLevels = 1);
 
-void transitionImageLayout(
-    VkCommandBuffer commandBuffer,
+// fills the barrier and stages of a layout transition without recording it
+void imageLayoutBarrier(
     VkImage image,
     VkFormat format,
     VkImageLayout oldLayout,
-    VkImageLayout newLayout);
-void transitionImageLayoutSingleTime(
-    const Vk::Context& ctx,
+    VkImageLayout newLayout,
+    VkImageMemoryBarrier& barrier,
+    VkPipelineStageFlags& srcStage,
+    VkPipelineStageFlags& dstStage);
+void transitionImageLayout(
+    VkCommandBuffer commandBuffer,
     VkImage image,
     VkFormat format,
     VkImageLayout oldLayout,
@@ -99,16 +92,6 @@ void copyBufferToImage(
     const uint32_t mipLevel = 0,
     const VkOffset3D& imageOffset = { 0, 0, 0 },
     const VkDeviceSize& bufferOffset = 0);
-void copyBufferToImageSingleTime(
-    const Context& ctx,
-    VkBuffer buffer,
-    VkImage image,
-    VkImageLayout imageLayout,
-    VkFormat format,
-    const VkExtent3D& extent,
-    const uint32_t mipLevel = 0,
-    const VkOffset3D& imageOffset = { 0, 0, 0 },
-    const VkDeviceSize& bufferOffset = 0);
 void copyImageToBuffer(
     VkCommandBuffer commandBuffer,
     VkImage image,
@@ -119,16 +102,6 @@ void copyImageToBuffer(
     const uint32_t mipLevel = 0,
     const VkOffset3D& imageOffset = { 0, 0, 0 },
     const VkDeviceSize& bufferOffset = 0);
-void copyImageToBufferSingleTime(
-    const Context& ctx,
-    VkImage image,
-    VkBuffer buffer,
-    VkImageLayout imageLayout,
-    VkFormat format,
-    const VkExtent3D& extent,
-    const uint32_t mipLevel = 0,
-    const VkOffset3D& imageOffset = { 0, 0, 0 },
-    const VkDeviceSize& bufferOffset = 0);
 void copyImageToImage(
     VkCommandBuffer commandBuffer,
     VkImage src,
@@ -142,19 +115,6 @@ void copyImageToImage(
     const uint32_t dstMipLevel = 0,
     const VkOffset3D& srcOffset = { 0, 0, 0 },
     const VkOffset3D& dstOffset = { 0, 0, 0 });
-void copyImageToImageSingleTime(
-    const Context& ctx,
-    VkImage src,
-    VkImage dst,
-    VkImageLayout srcLayout,
-    VkImageLayout dstLayout,
-    VkFormat srcFormat,
-    VkFormat dstFormat,
-    const VkExtent3D& extent,
-    const uint32_t srcMipLevel = 0,
-    const uint32_t dstMipLevel = 0,
-    const VkOffset3D& srcOffset = { 0, 0, 0 },
-    const VkOffset3D& dstOffset = { 0, 0, 0 });
 
 VkShaderModule createShaderModule(const Vk::Context& ctx, const std::vector<char>& code);
 
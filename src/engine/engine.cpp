@@ -1,26 +1,44 @@
 #include "engine.h"
 #include "core/tool/logger.h"
+#include "core/tool/tracer.h"
+#include "function/resource_manager/resource_manager.h"
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <glm/glm.hpp>
 
 void Engine::init(Configuration& config, RenderEngine* render_engine, UIEngine* ui_engine, PhysicsEngine* physics_engine)
 {
     logger.init(config);
+    tracer.init(config.tracer);
     INFO_FILE("Initializing the engine...");
 
     this->render_engine = render_engine;
     this->ui_engine = ui_engine;
     this->physics_engine = physics_engine;
+    this->config = config;
+    headless = config.headless.enabled;
+    headless_frames = config.headless.frames;
 
     render_engine->init_core(config);
     window = render_engine->getGLFWWindow();
 
     g_ctx.init(config, window);
 
-    render_engine->init_render(config, &g_ctx, ui_engine->getDrawUIFunction());
+    // without a window there is no input and nothing to draw the UI onto
+    if (headless)
+        render_engine->init_render(config, &g_ctx, [](VkCommandBuffer) { });
+    else
+        render_engine->init_render(config, &g_ctx, ui_engine->getDrawUIFunction());
 
     physics_engine->init(config, &g_ctx);
 
-    ui_engine->init(config, render_engine->toUI()); // get renderpass from render graph
+    if (!headless)
+        ui_engine->init(config, render_engine->toUI()); // get renderpass from render graph
+
+    // offline renders keep the configured quality
+    FieldBudgetConfiguration budget = config.field_budget;
+    budget.enabled = budget.enabled && !headless;
+    field_budget.init(budget);
 
     INFO_FILE("Engineinitialized");
 }
@@ -33,22 +51,98 @@ void Engine::update_frame_time()
     currentTime = std::chrono::high_resolution_clock::now();
 }
 
-void Engine::run()
+bool Engine::running() const
 {
-    while (!glfwWindowShouldClose(window)) {
-        INFO_FILE("Engine loop started");
+    if (headless)
+        return headless_frames == 0 || g_ctx.currentFrame < headless_frames;
+    return !glfwWindowShouldClose(window);
+}
 
-        glfwPollEvents();
+void Engine::frame()
+{
+    PROFILE_SCOPE("frame");
+    TRACE_FILE("Engine loop started");
 
-        update_frame_time();
+    update_frame_time();
 
+    if (!headless) {
+        PROFILE_SCOPE("handleInput");
+        glfwPollEvents();
         ui_engine->handleInput();
-        render_engine->render();
-        physics_engine->step();
+    }
+    field_budget.update();
+    render_engine->render();
+    physics_engine->step();
+
+    TRACE_FILE("Engine loop ended");
+
+    g_ctx.currentFrame++;
+}
 
-        INFO_FILE("Engine loop ended");
+void Engine::run()
+{
+    while (running())
+        frame();
+}
 
-        g_ctx.currentFrame++;
+static void applyCameraPath(const std::vector<CameraKeyframe>& path, float time)
+{
+    auto next = std::find_if(path.begin(), path.end(), [time](const CameraKeyframe& k) { return k.time > time; });
+    auto prev = next == path.begin() ? next : next - 1;
+    if (next == path.end())
+        next = prev;
+
+    float t = next->time > prev->time ? (time - prev->time) / (next->time - prev->time) : 0.0f;
+    glm::vec3 position = glm::mix(
+        glm::vec3(prev->position[0], prev->position[1], prev->position[2]),
+        glm::vec3(next->position[0], next->position[1], next->position[2]),
+        t);
+    glm::vec2 rotation = glm::mix(
+        glm::vec2(prev->rotation[0], prev->rotation[1]),
+        glm::vec2(next->rotation[0], next->rotation[1]),
+        t);
+
+    auto& camera = g_ctx.rm->camera;
+    camera.rotation = rotation;
+    camera.update_rotation(rotation);
+    camera.update_position(position);
+}
+
+void Engine::runBatch(const BatchConfiguration& batch)
+{
+    assert(headless);
+    auto camera_path = batch.camera_path;
+    std::sort(camera_path.begin(), camera_path.end(), [](const CameraKeyframe& a, const CameraKeyframe& b) {
+        return a.time < b.time;
+    });
+
+    const size_t run_count = std::max<size_t>(1, batch.sweep.values.size());
+    for (size_t run = 0; run < run_count; run++) {
+        // the previous run must be done with the parameters and the recorder
+        render_engine->sync();
+        if (!batch.sweep.values.empty())
+            g_ctx.rm->fields.setParameter(batch.sweep.field, batch.sweep.parameter, batch.sweep.values[run]);
+
+        std::string path = batch.output_path;
+        auto pos = path.find("{}");
+        if (pos != std::string::npos)
+            path.replace(pos, 2, std::to_string(run));
+        g_ctx.rm->recorder.begin(
+            path,
+            g_ctx.vk.swapChainImages[0]->extent.width,
+            g_ctx.vk.swapChainImages[0]->extent.height);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < batch.frames; i++) {
+            if (!camera_path.empty())
+                applyCameraPath(camera_path, i / float(config.recorder.frame_rate));
+            frame();
+        }
+        render_engine->sync();
+        g_ctx.rm->recorder.end();
+
+        float seconds = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+        INFO_ALL("Batch run {}/{}: {} frames in {:.1f}s written to {}", run + 1, run_count, batch.frames, seconds, path);
     }
 }
 
@@ -60,9 +154,14 @@ void Engine::cleanup()
     physics_engine->sync();
 
     physics_engine->cleanup();
-    ui_engine->cleanup();
+    if (!headless)
+        ui_engine->cleanup();
     render_engine->cleanup();
     g_ctx.cleanup();
 
+    if (tracer.enabled())
+        tracer.dump();
+
     INFO_FILE("Engine cleanup ended");
+    logger.shutdown();
 }
@@ -4,6 +4,7 @@
 #include "function/global_context.h"
 #include "function/physics/physics_engine.h"
 #include "function/render/render_engine.h"
+#include "function/tool/field_budget.h"
 #include "function/ui/ui_engine.h"
 
 struct ImDrawData;
@@ -20,13 +21,20 @@ class Engine {
 
     GLFWwindow* window;
     Configuration config;
+    bool headless = false;
+    uint32_t headless_frames = 0;
+    FieldBudget field_budget;
 
     std::chrono::time_point<std::chrono::high_resolution_clock> currentTime = std::chrono::high_resolution_clock::now();
 
     void update_frame_time();
+    bool running() const;
+    void frame();
 
 public:
     void init(Configuration& config, RenderEngine* render_engine, UIEngine* ui_engine, PhysicsEngine* physics_engine);
     void run();
+    // renders every run of the batch back to back, init with headless enabled
+    void runBatch(const BatchConfiguration& batch);
     void cleanup();
 };
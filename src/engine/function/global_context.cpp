@@ -1,4 +1,6 @@
 #include "global_context.h"
+#include "core/vulkan/memory_allocator.h"
+#include "core/vulkan/upload_manager.h"
 #include "function/resource_manager/resource_manager.h"
 
 GlobalContext g_ctx;
@@ -10,14 +12,21 @@ void GlobalContext::init(Configuration& config, GLFWwindow* window)
 {
     vk.init(config, window);
     dm.init(&vk);
+    gpu_profiler.init(vk);
+    uniforms.init(vk);
 
     rm = std::make_unique<ResourceManager>();
     rm->load(config);
+    // CUDA may use the exported buffers and images as soon as init returns
+    vk.uploader->flush();
+    vk.allocator->dumpStats();
 }
 
 void GlobalContext::cleanup()
 {
     rm->cleanup();
     dm.cleanup();
+    gpu_profiler.destroy();
+    uniforms.destroy();
     vk.cleanup();
 }
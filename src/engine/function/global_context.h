@@ -1,6 +1,8 @@
 #pragma once
 
 #include "core/vulkan/descriptor_manager.h"
+#include "core/vulkan/gpu_profiler.h"
+#include "core/vulkan/uniform_ring.h"
 #include "core/vulkan/vulkan_context.h"
 
 #ifdef _WIN64
@@ -19,10 +21,14 @@ struct GlobalContext {
 
     Vk::Context vk;
     Vk::DescriptorManager dm;
+    Vk::GpuProfiler gpu_profiler;
+    Vk::UniformRing uniforms;
     std::unique_ptr<ResourceManager> rm;
 
     float frame_time = 0.0f;
     uint32_t currentFrame = 0;
+    // index of the per frame copies used by currentFrame
+    uint32_t frameSlot() const { return currentFrame % vk.framesInFlight; }
 };
 
 extern GlobalContext g_ctx;
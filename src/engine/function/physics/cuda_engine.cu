@@ -1,4 +1,5 @@
 #include "core/config/config.h"
+#include "core/tool/tracer.h"
 #include "core/vulkan/vulkan_context.h"
 #include "cuda_engine.h"
 #include "function/global_context.h"
@@ -107,10 +108,10 @@ void CudaEngine::initSemaphore()
     cudaExternalSemaphoreHandleDesc externalSemaphoreHandleDesc;
     memset(&externalSemaphoreHandleDesc, 0, sizeof(externalSemaphoreHandleDesc));
 #ifdef _WIN64
-    externalSemaphoreHandleDesc.type = cudaExternalSemaphoreHandleTypeOpaqueWin32;
+    externalSemaphoreHandleDesc.type = cudaExternalSemaphoreHandleTypeTimelineSemaphoreWin32;
     externalSemaphoreHandleDesc.handle.win32.handle = Vk::ctx.cuUpdateSemaphoreHandle;
 #else
-    externalSemaphoreHandleDesc.type = cudaExternalSemaphoreHandleTypeOpaqueFd;
+    externalSemaphoreHandleDesc.type = cudaExternalSemaphoreHandleTypeTimelineSemaphoreFd;
     externalSemaphoreHandleDesc.handle.fd = g_ctx->vk.cuUpdateSemaphoreFd;
 #endif
     externalSemaphoreHandleDesc.flags = 0;
@@ -118,10 +119,10 @@ void CudaEngine::initSemaphore()
 
     memset(&externalSemaphoreHandleDesc, 0, sizeof(externalSemaphoreHandleDesc));
 #ifdef _WIN64
-    externalSemaphoreHandleDesc.type = cudaExternalSemaphoreHandleTypeOpaqueWin32;
+    externalSemaphoreHandleDesc.type = cudaExternalSemaphoreHandleTypeTimelineSemaphoreWin32;
     externalSemaphoreHandleDesc.handle.win32.handle = Vk::ctx.vkUpdateSemaphoreHandle;
 #else
-    externalSemaphoreHandleDesc.type = cudaExternalSemaphoreHandleTypeOpaqueFd;
+    externalSemaphoreHandleDesc.type = cudaExternalSemaphoreHandleTypeTimelineSemaphoreFd;
     externalSemaphoreHandleDesc.handle.fd = g_ctx->vk.vkUpdateSemaphoreFd;
 #endif
     externalSemaphoreHandleDesc.flags = 0;
@@ -139,15 +140,28 @@ void CudaEngine::init(Configuration& config, GlobalContext* g_ctx)
     frame_rate = config.driver.frame_rate;
     steps_per_frame = config.driver.steps_per_frame;
     current_frame = 0;
+    pipeline_depth = g_ctx->vk.pipelineDepth;
 }
 
 void CudaEngine::step()
 {
-    waitOnSemaphore(vkUpdateSemaphore);
+    PROFILE_SCOPE("PhysicsEngine::step");
+    waitOnSemaphore(vkUpdateSemaphore, renderedFrameValue());
 
     // TODO
 
-    signalSemaphore(cuUpdateSemaphore);
+    signalSemaphore(cuUpdateSemaphore, steppedFrameValue());
+}
+
+uint64_t CudaEngine::renderedFrameValue() const
+{
+    int64_t value = int64_t(g_ctx->currentFrame) + 2 - pipeline_depth;
+    return value > 0 ? value : 0;
+}
+
+uint64_t CudaEngine::steppedFrameValue() const
+{
+    return uint64_t(g_ctx->currentFrame) + 1;
 }
 
 void CudaEngine::sync()
@@ -167,22 +181,22 @@ void CudaEngine::cleanup()
     cudaDestroyExternalSemaphore(cuUpdateSemaphore);
 }
 
-void CudaEngine::waitOnSemaphore(cudaExternalSemaphore_t& semaphore)
+void CudaEngine::waitOnSemaphore(cudaExternalSemaphore_t& semaphore, uint64_t value)
 {
     cudaExternalSemaphoreWaitParams extSemaphoreWaitParams;
     memset(&extSemaphoreWaitParams, 0, sizeof(extSemaphoreWaitParams));
-    extSemaphoreWaitParams.params.fence.value = 0;
+    extSemaphoreWaitParams.params.fence.value = value;
     extSemaphoreWaitParams.flags = 0;
 
     cudaWaitExternalSemaphoresAsync(
         &semaphore, &extSemaphoreWaitParams, 1, streamToRun);
 }
 
-void CudaEngine::signalSemaphore(cudaExternalSemaphore_t& semaphore)
+void CudaEngine::signalSemaphore(cudaExternalSemaphore_t& semaphore, uint64_t value)
 {
     cudaExternalSemaphoreSignalParams extSemaphoreSignalParams;
     memset(&extSemaphoreSignalParams, 0, sizeof(extSemaphoreSignalParams));
-    extSemaphoreSignalParams.params.fence.value = 0;
+    extSemaphoreSignalParams.params.fence.value = value;
     extSemaphoreSignalParams.flags = 0;
 
     cudaSignalExternalSemaphoresAsync(
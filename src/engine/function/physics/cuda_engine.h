@@ -75,13 +75,17 @@ protected:
     int frame_rate;
     int steps_per_frame;
     int current_frame;
+    uint32_t pipeline_depth;
 
     void initSemaphore();
     void importExtBuffer(const ExtBufferDesc& buffer_desc);
     // single channel image only
     void importExtImage(const ExtImageDesc& image_desc);
-    void waitOnSemaphore(cudaExternalSemaphore_t& semaphore);
-    void signalSemaphore(cudaExternalSemaphore_t& semaphore);
+    void waitOnSemaphore(cudaExternalSemaphore_t& semaphore, uint64_t value);
+    void signalSemaphore(cudaExternalSemaphore_t& semaphore, uint64_t value);
+    // timeline values for the current frame, see Vk::Context::cuUpdateSemaphore
+    uint64_t renderedFrameValue() const;
+    uint64_t steppedFrameValue() const;
 
     virtual void initExternalMem();
 
@@ -1,5 +1,7 @@
 #include "render_engine.h"
+#include "core/tool/tracer.h"
 #include "core/vulkan/descriptor_manager.h"
+#include "core/vulkan/upload_manager.h"
 #include "core/vulkan/vulkan_context.h"
 #include "function/global_context.h"
 #include "function/render/render_graph/graph/graph.h"
@@ -15,7 +17,9 @@ void RenderEngine::init_core(const Configuration& config)
     base_window_name = config.name;
     this->config = &const_cast<Configuration&>(config);
 
-    initGLFW();
+    window = nullptr;
+    if (!config.headless.enabled)
+        initGLFW();
 }
 
 void RenderEngine::init_render(const Configuration& config, GlobalContext* g_ctx, std::function<void(VkCommandBuffer)> fn)
@@ -40,6 +44,8 @@ void RenderEngine::initRenderGraph(std::function<void(VkCommandBuffer)> fn)
 void RenderEngine::render()
 {
     draw();
+    if (window == nullptr)
+        return;
 
     auto name = base_window_name + " " + std::to_string(g_ctx->frame_time * 1000) + "ms";
     glfwSetWindowTitle(window, name.c_str());
@@ -47,75 +53,119 @@ void RenderEngine::render()
 
 void RenderEngine::draw()
 {
-    vkWaitForFences(g_ctx->vk.device, 1, &g_ctx->vk.inFlightFences[g_ctx->currentFrame % MAX_FRAMES_IN_FLIGHT], VK_TRUE, UINT64_MAX);
-
-    uint32_t swapchain_index;
-    VkResult result = vkAcquireNextImageKHR(
-        g_ctx->vk.device,
-        g_ctx->vk.swapChain,
-        UINT64_MAX,
-        g_ctx->vk.imageAvailableSemaphores[g_ctx->currentFrame % MAX_FRAMES_IN_FLIGHT],
-        VK_NULL_HANDLE,
-        &swapchain_index);
-    while (result == VK_ERROR_OUT_OF_DATE_KHR) {
-        onResize();
-        vkWaitForFences(
-            g_ctx->vk.device, 1,
-            &g_ctx->vk.inFlightFences[g_ctx->currentFrame % MAX_FRAMES_IN_FLIGHT],
-            VK_TRUE, UINT64_MAX);
-        result = vkAcquireNextImageKHR(
-            g_ctx->vk.device, g_ctx->vk.swapChain,
-            UINT64_MAX,
-            g_ctx->vk.imageAvailableSemaphores[g_ctx->currentFrame % MAX_FRAMES_IN_FLIGHT],
-            VK_NULL_HANDLE,
-            &swapchain_index);
+    PROFILE_SCOPE("draw");
+    const uint32_t slot = g_ctx->frameSlot();
+    {
+        PROFILE_SCOPE("fence wait");
+        vkWaitForFences(g_ctx->vk.device, 1, &g_ctx->vk.inFlightFences[slot], VK_TRUE, UINT64_MAX);
     }
-    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-        throw std::runtime_error("failed to acquire swap chain image!");
+    g_ctx->dm.beginFrame(slot);
+    g_ctx->uniforms.beginFrame(slot);
+
+    // offscreen images are used round robin, the fence of the slot already
+    // guarantees that its image is free
+    uint32_t swapchain_index = slot;
+    VkResult result = VK_SUCCESS;
+    {
+        PROFILE_SCOPE("acquire");
+        if (!g_ctx->vk.headless) {
+            result = vkAcquireNextImageKHR(
+                g_ctx->vk.device,
+                g_ctx->vk.swapChain,
+                UINT64_MAX,
+                g_ctx->vk.imageAvailableSemaphores[slot],
+                VK_NULL_HANDLE,
+                &swapchain_index);
+        }
+        while (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            onResize();
+            vkWaitForFences(
+                g_ctx->vk.device, 1,
+                &g_ctx->vk.inFlightFences[slot],
+                VK_TRUE, UINT64_MAX);
+            result = vkAcquireNextImageKHR(
+                g_ctx->vk.device, g_ctx->vk.swapChain,
+                UINT64_MAX,
+                g_ctx->vk.imageAvailableSemaphores[slot],
+                VK_NULL_HANDLE,
+                &swapchain_index);
+        }
+        if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            throw std::runtime_error("failed to acquire swap chain image!");
+        }
     }
 
-    vkResetFences(g_ctx->vk.device, 1, &g_ctx->vk.inFlightFences[g_ctx->currentFrame % MAX_FRAMES_IN_FLIGHT]);
+    g_ctx->dm.flush();
+    vkResetFences(g_ctx->vk.device, 1, &g_ctx->vk.inFlightFences[slot]);
 
-    vkResetCommandBuffer(g_ctx->vk.commandBuffer, 0);
+    // the fence guarantees the GPU is done with everything of this slot
+    vkResetCommandPool(g_ctx->vk.device, g_ctx->vk.frameCommandPools[slot], 0);
+    g_ctx->vk.commandBuffer = g_ctx->vk.frameCommandBuffers[slot];
 
     {
+        PROFILE_SCOPE("record");
         render_graph->record(swapchain_index);
+        // after recording so that changes made by the UI land in this frame
+        g_ctx->rm->flushFrameData(slot);
     }
 
     VkSubmitInfo submitInfo {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-    std::vector<VkSemaphore> waitSemaphores = { g_ctx->vk.imageAvailableSemaphores[g_ctx->currentFrame % MAX_FRAMES_IN_FLIGHT] };
-    if (g_ctx->currentFrame != 0)
-        waitSemaphores.emplace_back(g_ctx->vk.cuUpdateSemaphore);
-    std::vector<VkPipelineStageFlags> waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    if (g_ctx->currentFrame != 0)
-        waitStages.emplace_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-    submitInfo.waitSemaphoreCount = waitSemaphores.size();
-    submitInfo.pWaitSemaphores = waitSemaphores.data();
-    submitInfo.pWaitDstStageMask = waitStages.data();
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &g_ctx->vk.commandBuffer;
-
+    // the swapchain semaphores come last so headless frames can drop them
+    VkSemaphore waitSemaphores[] = {
+        g_ctx->vk.cuUpdateSemaphore,
+        g_ctx->vk.imageAvailableSemaphores[slot]
+    };
+    VkPipelineStageFlags waitStages[] = {
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+    };
     VkSemaphore signalSemaphores[] = {
-        g_ctx->vk.renderFinishedSemaphores[g_ctx->currentFrame % MAX_FRAMES_IN_FLIGHT],
-        g_ctx->vk.vkUpdateSemaphore
+        g_ctx->vk.vkUpdateSemaphore,
+        g_ctx->vk.renderFinishedSemaphores[slot]
     };
-    submitInfo.signalSemaphoreCount = 2;
+    // values of the binary semaphores are ignored
+    uint64_t waitValues[] = { g_ctx->currentFrame, 0 };
+    uint64_t signalValues[] = { uint64_t(g_ctx->currentFrame) + 1, 0 };
+    const uint32_t semaphoreCount = g_ctx->vk.headless ? 1 : 2;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = semaphoreCount;
+    timelineInfo.pWaitSemaphoreValues = waitValues;
+    timelineInfo.signalSemaphoreValueCount = semaphoreCount;
+    timelineInfo.pSignalSemaphoreValues = signalValues;
+
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = semaphoreCount;
+    submitInfo.pWaitSemaphores = waitSemaphores;
+    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &g_ctx->vk.commandBuffer;
+    submitInfo.signalSemaphoreCount = semaphoreCount;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
-    if (vkQueueSubmit(g_ctx->vk.queue, 1, &submitInfo, g_ctx->vk.inFlightFences[g_ctx->currentFrame % MAX_FRAMES_IN_FLIGHT]) != VK_SUCCESS) {
-        throw std::runtime_error("failed to submit draw command buffer!");
+    {
+        PROFILE_SCOPE("submit");
+        // transfers queued since the last frame go ahead of it
+        g_ctx->vk.uploader->submit();
+        if (vkQueueSubmit(g_ctx->vk.queue, 1, &submitInfo, g_ctx->vk.inFlightFences[slot]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit draw command buffer!");
+        }
     }
+    if (g_ctx->vk.headless)
+        return;
 
     VkSwapchainKHR swapChains[] = { g_ctx->vk.swapChain };
     VkPresentInfoKHR presentInfo {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
+    presentInfo.pWaitSemaphores = &signalSemaphores[1];
     presentInfo.swapchainCount = 1;
     presentInfo.pSwapchains = swapChains;
     presentInfo.pImageIndices = &swapchain_index;
+    PROFILE_SCOPE("present");
     result = vkQueuePresentKHR(g_ctx->vk.presentQueue, &presentInfo);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) {
@@ -195,6 +245,8 @@ void RenderEngine::cleanup()
 {
     render_graph->destroy();
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (window != nullptr) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 }
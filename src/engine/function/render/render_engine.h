@@ -45,6 +45,4 @@ private:
     std::string base_window_name;
     std::unique_ptr<Vk2ImGui> vk2im;
     bool framebufferResized = false;
-
-    static constexpr int MAX_FRAMES_IN_FLIGHT = 1;
 };
@@ -10,13 +10,15 @@ void FireGraph::init(Configuration& cfg)
         = std::move(std::make_unique<HDRToSDR>("HDRToSDR", "field_object_color", RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME()));
     nodes["UI"]
         = std::move(std::make_unique<UI>("UI", RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME(), fn));
-    nodes["Record"]
-        = std::move(std::make_unique<Record>("Record", RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME()));
-    initAttachments();
-
-    for (auto& node : nodes) {
-        node.second->init(cfg, attachments);
-    }
+    if (cfg.recorder.image_export.enabled)
+        nodes["Record"]
+            = std::move(std::make_unique<RecordExport>("Record", "field_object_color", "depth"));
+    else if (cfg.recorder.gpu_yuv)
+        nodes["Record"]
+            = std::move(std::make_unique<RecordYUV>("Record", "field_object_color", true));
+    else
+        nodes["Record"]
+            = std::move(std::make_unique<Record>("Record", RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME()));
 
     graph = {
         { "Field", { "FireObject" } },
@@ -25,4 +27,12 @@ void FireGraph::init(Configuration& cfg)
         { "UI", { "Record", "HDRToSDR" } },
     };
     initGraph();
+    initAttachments();
+
+    for (auto& node : nodes) {
+        node.second->init(cfg, attachments);
+    }
+
+    initSecondaryRecording(cfg.frame_pipeline.record_threads);
+    compile();
 }
@@ -24,7 +24,9 @@ public:
         const std::string& depth_buf_name);
 
     virtual void init(Configuration& cfg, RenderAttachments& attachments) override;
-    virtual void record(uint32_t swapchain_index) override;
+    virtual bool recordsContents() const override { return true; }
+    virtual RenderPassBegin renderPassBegin(uint32_t swapchain_index) override;
+    virtual void recordContents(VkCommandBuffer cmd, uint32_t swapchain_index) override;
     virtual void onResize() override;
     virtual void destroy() override;
 };
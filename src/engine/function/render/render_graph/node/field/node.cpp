@@ -49,6 +49,7 @@ FieldNode::FieldNode(const std::string& name,
                 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
                 VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
                 VK_FORMAT_R32G32B32A32_SFLOAT,
+                true,
             },
         },
     };
@@ -106,8 +107,8 @@ void FieldNode::createPipeline(Configuration& cfg)
     {
         std::vector<VkDescriptorSetLayout> descLayouts = {
             g_ctx.dm.BINDLESS_LAYOUT(),
-            g_ctx.dm.PARAMETER_LAYOUT(),
-            g_ctx.dm.PARAMETER_LAYOUT(),
+            g_ctx.uniforms.LAYOUT(),
+            g_ctx.uniforms.LAYOUT(),
         };
         VkPushConstantRange pushConstantRange {};
         pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -205,61 +206,52 @@ void FieldNode::createPipeline(Configuration& cfg)
     }
 
     {
-        pipeline.param.camera = g_ctx.dm.getResourceHandle(g_ctx.rm->camera.buffer.id);
-        pipeline.param.lights = g_ctx.dm.getResourceHandle(g_ctx.rm->lights.buffer.id);
-        pipeline.param.self_illumination_lights = g_ctx.dm.getResourceHandle(
-            g_ctx.rm->fields.self_illumination_lights.buffer.id);
-        pipeline.param.fire_color = g_ctx.dm.getResourceHandle(
-            g_ctx.rm->fields.fire_color_img.id);
-        pipeline.param.previous_color = g_ctx.dm.getResourceHandle(
-            attachments->getAttachment(attachment_descriptions["previous_color"].name).id);
-        pipeline.param.previous_depth = g_ctx.dm.getResourceHandle(
-            attachments->getAttachment(attachment_descriptions["previous_depth"].name).id);
-        pipeline.param_buf = Buffer::New(
-            g_ctx.vk,
-            sizeof(Param),
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            true);
-        pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
-        g_ctx.dm.registerParameter(pipeline.param_buf);
+        pipeline.initParameters([&](Param& param, uint32_t slot) {
+            param.camera = g_ctx.dm.getResourceHandle(g_ctx.rm->camera.buffer[slot].descriptor);
+            param.lights = g_ctx.dm.getResourceHandle(g_ctx.rm->lights.buffer[slot].descriptor);
+            param.self_illumination_lights = g_ctx.dm.getResourceHandle(
+                g_ctx.rm->fields.self_illumination_lights.buffer.descriptor);
+            param.fire_color = g_ctx.dm.getResourceHandle(
+                g_ctx.rm->fields.fire_color_img.descriptor);
+            param.previous_color = g_ctx.dm.getResourceHandle(
+                attachments->getAttachment(attachment_descriptions["previous_color"].name).descriptor);
+            param.previous_depth = g_ctx.dm.getResourceHandle(
+                attachments->getAttachment(attachment_descriptions["previous_depth"].name).descriptor);
+        });
     }
 }
 
-void FieldNode::record(uint32_t swapchain_index)
+RenderGraphNode::RenderPassBegin FieldNode::renderPassBegin(uint32_t swapchain_index)
 {
-    setDefaultViewportAndScissor();
+    RenderPassBegin begin;
+    begin.render_pass = render_pass;
+    begin.framebuffer = framebuffers[swapchain_index];
+    begin.clear_values.resize(2);
+    begin.clear_values[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } }; // dummy
+    begin.clear_values[1].depthStencil = { 1.0f, 0 };
+    return begin;
+}
 
-    std::array<VkClearValue, 2> clearValues {};
-    clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } }; // dummy
-    clearValues[1].depthStencil = { 1.0f, 0 };
-    VkRenderPassBeginInfo renderPassInfo {};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = render_pass;
-    renderPassInfo.framebuffer = framebuffers[swapchain_index];
-    renderPassInfo.renderArea.offset = { 0, 0 };
-    renderPassInfo.renderArea.extent = toVkExtent2D(g_ctx.vk.swapChainImages[swapchain_index]->extent);
-    renderPassInfo.clearValueCount = clearValues.size();
-    renderPassInfo.pClearValues = clearValues.data();
-    vkCmdBeginRenderPass(g_ctx.vk.commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+void FieldNode::recordContents(VkCommandBuffer cmd, uint32_t swapchain_index)
+{
+    setDefaultViewportAndScissor(cmd);
 
-    vkCmdBindPipeline(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
-    bindDescriptorSet(0, pipeline.layout, g_ctx.dm.BINDLESS_SET());
-    bindDescriptorSet(1, pipeline.layout, g_ctx.dm.getParameterSet(pipeline.param_buf.id));
-    bindDescriptorSet(2, pipeline.layout,
-        g_ctx.dm.getParameterSet(g_ctx.rm->fields.paramBuffer.id));
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+    bindDescriptorSet(cmd, 0, pipeline.layout, g_ctx.dm.BINDLESS_SET());
+    pipeline.bindParameters(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS);
+    const auto& fields = g_ctx.rm->fields;
+    uint32_t offset = g_ctx.uniforms.push(&fields.params[fields.renderBuffer(g_ctx.currentFrame)], sizeof(Fields::Param));
+    g_ctx.uniforms.bind(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.layout, 2, offset);
+    float step = g_ctx.rm->fields.step * g_ctx.rm->fields.step_scale;
     vkCmdPushConstants(
-        g_ctx.vk.commandBuffer,
+        cmd,
         pipeline.layout,
         VK_SHADER_STAGE_FRAGMENT_BIT,
         0,
-        sizeof(g_ctx.rm->fields.step),
-        &g_ctx.rm->fields.step);
-
-    VkDeviceSize offsets[] = { 0 };
-    vkCmdDraw(g_ctx.vk.commandBuffer, 6, 1, 0, 0);
+        sizeof(step),
+        &step);
 
-    vkCmdEndRenderPass(g_ctx.vk.commandBuffer);
+    vkCmdDraw(cmd, 6, 1, 0, 0);
 }
 
 void FieldNode::onResize()
@@ -268,6 +260,8 @@ void FieldNode::onResize()
         vkDestroyFramebuffer(g_ctx.vk.device, framebuffer, nullptr);
     }
     createFramebuffer();
+    // the sampled attachments were registered again under new handles
+    pipeline.refreshParameters();
 }
 
 void FieldNode::destroy()
@@ -280,8 +280,9 @@ vec4 volumetric_color_multi(vec3 origin, vec3 ray, float depth, mat4x4 proj_view
         t_entry = min(t_entry, t_entry_i);
         t_exit = max(t_exit, t_exit_i);
     }
+    // alpha is the transmittance through the fields alone, for compositing
     if (!has_intersection)
-        return object_color;
+        return vec4(object_color.rgb, 1.0);
 
     vec4 clip_ray = proj_view * vec4(ray, 0.0);
     vec4 clip_origin = proj_view * vec4(origin + camera.focal_distance * ray, 1.0);
@@ -332,7 +333,7 @@ vec4 volumetric_color_multi(vec3 origin, vec3 ray, float depth, mat4x4 proj_view
         t += step;
     }
 
-    return vec4(color + transmittance * object_color.rgb, object_color.a);
+    return vec4(color + transmittance * object_color.rgb, dot(transmittance, vec3(1.0 / 3.0)));
 }
 
 void main()
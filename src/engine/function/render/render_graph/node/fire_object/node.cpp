@@ -91,8 +91,8 @@ void FireObject::createPipeline(Configuration& cfg)
     {
         std::vector<VkDescriptorSetLayout> descLayouts = {
             g_ctx.dm.BINDLESS_LAYOUT(),
-            g_ctx.dm.PARAMETER_LAYOUT(),
-            g_ctx.dm.PARAMETER_LAYOUT(),
+            g_ctx.uniforms.LAYOUT(),
+            g_ctx.uniforms.LAYOUT(),
         };
         pipeline.initLayout(descLayouts);
     }
@@ -168,52 +168,43 @@ void FireObject::createPipeline(Configuration& cfg)
 
     {
         assert(g_ctx.rm->fields.has_temperature);
-        pipeline.param.camera = g_ctx.dm.getResourceHandle(g_ctx.rm->camera.buffer.id);
-        pipeline.param.lights = g_ctx.dm.getResourceHandle(g_ctx.rm->lights.buffer.id);
-        pipeline.param.fire_lights = g_ctx.dm.getResourceHandle(g_ctx.rm->fields.lights.buffer.id);
-        pipeline.param_buf = Buffer::New(
-            g_ctx.vk,
-            sizeof(Param),
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            true);
-        pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
-        g_ctx.dm.registerParameter(pipeline.param_buf);
+        pipeline.initParameters([](Param& param, uint32_t slot) {
+            param.camera = g_ctx.dm.getResourceHandle(g_ctx.rm->camera.buffer[slot].descriptor);
+            param.lights = g_ctx.dm.getResourceHandle(g_ctx.rm->lights.buffer[slot].descriptor);
+            param.fire_lights = g_ctx.dm.getResourceHandle(g_ctx.rm->fields.lights.buffer[slot].descriptor);
+        });
     }
 }
 
-void FireObject::record(uint32_t swapchain_index)
+RenderGraphNode::RenderPassBegin FireObject::renderPassBegin(uint32_t swapchain_index)
 {
-    setDefaultViewportAndScissor();
-
-    std::array<VkClearValue, 2> clearValues {};
-    clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } }; // dummy
-    clearValues[1].depthStencil = { 1.0f, 0 };
-    VkRenderPassBeginInfo renderPassInfo {};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = render_pass;
-    renderPassInfo.framebuffer = framebuffers[swapchain_index];
-    renderPassInfo.renderArea.offset = { 0, 0 };
-    renderPassInfo.renderArea.extent = toVkExtent2D(g_ctx.vk.swapChainImages[swapchain_index]->extent);
-    renderPassInfo.clearValueCount = clearValues.size();
-    renderPassInfo.pClearValues = clearValues.data();
-    vkCmdBeginRenderPass(g_ctx.vk.commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-    vkCmdBindPipeline(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
-    bindDescriptorSet(0, pipeline.layout, g_ctx.dm.BINDLESS_SET());
-    bindDescriptorSet(1, pipeline.layout, g_ctx.dm.getParameterSet(pipeline.param_buf.id));
+    RenderPassBegin begin;
+    begin.render_pass = render_pass;
+    begin.framebuffer = framebuffers[swapchain_index];
+    begin.clear_values.resize(2);
+    begin.clear_values[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } }; // dummy
+    begin.clear_values[1].depthStencil = { 1.0f, 0 };
+    return begin;
+}
+
+void FireObject::recordContents(VkCommandBuffer cmd, uint32_t swapchain_index)
+{
+    setDefaultViewportAndScissor(cmd);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+    bindDescriptorSet(cmd, 0, pipeline.layout, g_ctx.dm.BINDLESS_SET());
+    pipeline.bindParameters(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS);
 
     for (const auto& obj : g_ctx.rm->objects) {
-        bindDescriptorSet(2, pipeline.layout, g_ctx.dm.getParameterSet(obj.paramBuffer.id));
-        const auto& mesh = g_ctx.rm->meshes[obj.mesh];
+        uint32_t offset = g_ctx.uniforms.push(&obj.params[g_ctx.frameSlot()], sizeof(Object::Param));
+        g_ctx.uniforms.bind(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.layout, 2, offset);
+        const auto& mesh = g_ctx.rm->meshes.at(obj.mesh);
 
         VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(g_ctx.vk.commandBuffer, 0, 1, &mesh.vertexBuffer.buffer, offsets);
-        vkCmdBindIndexBuffer(g_ctx.vk.commandBuffer, mesh.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-        vkCmdDrawIndexed(g_ctx.vk.commandBuffer, mesh.data.indices.size(), 1, 0, 0, 0);
+        vkCmdBindVertexBuffers(cmd, 0, 1, &mesh.vertexBuffer.buffer, offsets);
+        vkCmdBindIndexBuffer(cmd, mesh.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+        vkCmdDrawIndexed(cmd, mesh.data.indices.size(), 1, 0, 0, 0);
     }
-
-    vkCmdEndRenderPass(g_ctx.vk.commandBuffer);
 }
 
 void FireObject::onResize()
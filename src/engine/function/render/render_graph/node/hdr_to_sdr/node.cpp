@@ -32,6 +32,7 @@ HDRToSDR::HDRToSDR(const std::string& name, const std::string& hdr_buf, const st
                 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
                 VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
                 is_swapchain ? g_ctx.vk.swapChainImages[0]->format : VK_FORMAT_B8G8R8A8_UNORM,
+                true,
             },
         }
     };
@@ -92,7 +93,7 @@ void HDRToSDR::createPipeline(Configuration& cfg)
     {
         std::vector<VkDescriptorSetLayout> descLayouts = {
             g_ctx.dm.BINDLESS_LAYOUT(),
-            g_ctx.dm.PARAMETER_LAYOUT(),
+            g_ctx.uniforms.LAYOUT(),
         };
         pipeline.initLayout(descLayouts);
     }
@@ -154,40 +155,30 @@ void HDRToSDR::createPipeline(Configuration& cfg)
     }
 
     {
-        pipeline.param.hdr_img = g_ctx.dm.getResourceHandle(
-            attachments->getAttachment(attachment_descriptions["hdr"].name).id);
-        pipeline.param_buf = Buffer::New(
-            g_ctx.vk,
-            sizeof(Param),
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            true);
-        pipeline.param_buf.Update(g_ctx.vk, &pipeline.param, sizeof(Param));
-        g_ctx.dm.registerParameter(pipeline.param_buf);
+        pipeline.initParameters([&](Param& param, uint32_t slot) {
+            param.hdr_img = g_ctx.dm.getResourceHandle(
+                attachments->getAttachment(attachment_descriptions["hdr"].name).descriptor);
+        });
     }
 }
 
-void HDRToSDR::record(uint32_t swapchain_index)
+RenderGraphNode::RenderPassBegin HDRToSDR::renderPassBegin(uint32_t swapchain_index)
 {
-    setDefaultViewportAndScissor();
-
-    VkRenderPassBeginInfo renderPassInfo {};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = render_pass;
-    renderPassInfo.framebuffer = framebuffers[swapchain_index];
-    renderPassInfo.renderArea.offset = { 0, 0 };
-    renderPassInfo.renderArea.extent = toVkExtent2D(g_ctx.vk.swapChainImages[swapchain_index]->extent);
-    renderPassInfo.clearValueCount = 0;
-    renderPassInfo.pClearValues = nullptr;
-    vkCmdBeginRenderPass(g_ctx.vk.commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    RenderPassBegin begin;
+    begin.render_pass = render_pass;
+    begin.framebuffer = framebuffers[swapchain_index];
+    return begin;
+}
 
-    vkCmdBindPipeline(g_ctx.vk.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
-    bindDescriptorSet(0, pipeline.layout, g_ctx.dm.BINDLESS_SET());
-    bindDescriptorSet(1, pipeline.layout, g_ctx.dm.getParameterSet(pipeline.param_buf.id));
+void HDRToSDR::recordContents(VkCommandBuffer cmd, uint32_t swapchain_index)
+{
+    setDefaultViewportAndScissor(cmd);
 
-    vkCmdDraw(g_ctx.vk.commandBuffer, 6, 1, 0, 0);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+    bindDescriptorSet(cmd, 0, pipeline.layout, g_ctx.dm.BINDLESS_SET());
+    pipeline.bindParameters(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS);
 
-    vkCmdEndRenderPass(g_ctx.vk.commandBuffer);
+    vkCmdDraw(cmd, 6, 1, 0, 0);
 }
 
 void HDRToSDR::onResize()
@@ -196,6 +187,8 @@ void HDRToSDR::onResize()
         vkDestroyFramebuffer(g_ctx.vk.device, framebuffer, nullptr);
     }
     createFramebuffer();
+    // the sampled attachments were registered again under new handles
+    pipeline.refreshParameters();
 }
 
 void HDRToSDR::destroy()
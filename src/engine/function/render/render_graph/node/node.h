@@ -2,5 +2,7 @@
 #include "./field/node.h"
 #include "./fire_object/node.h"
 #include "./hdr_to_sdr/node.h"
+#include "./record_export/node.h"
+#include "./record_yuv/node.h"
 #include "./recorder/node.h"
 #include "./ui/node.h"
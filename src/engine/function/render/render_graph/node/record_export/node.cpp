@@ -0,0 +1,65 @@
+#include "./node.h"
+#include "function/global_context.h"
+#include "function/resource_manager/resource_manager.h"
+
+using namespace Vk;
+
+RecordExport::RecordExport(const std::string& name, const std::string& color_buf_name, const std::string& depth_buf_name)
+    : Record(name)
+{
+    assert(color_buf_name != RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME());
+
+    attachment_descriptions = {
+        {
+            "color",
+            {
+                color_buf_name,
+                RenderAttachmentType::Color,
+                RenderAttachmentRW::Read,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                VK_FORMAT_R32G32B32A32_SFLOAT,
+            },
+        },
+        {
+            "depth",
+            RenderAttachmentDescription {
+                depth_buf_name,
+                RenderAttachmentType::Depth,
+                RenderAttachmentRW::Read,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                VK_FORMAT_D32_SFLOAT,
+            },
+        },
+    };
+}
+
+void RecordExport::init(Configuration& cfg, RenderAttachments& attachments)
+{
+    g_ctx.rm->recorder.input = Recorder::Input::HDR;
+    Record::init(cfg, attachments);
+}
+
+void RecordExport::createBuffers()
+{
+    const auto& extent = g_ctx.vk.swapChainImages[0]->extent;
+    readbacks.resize(g_ctx.vk.framesInFlight);
+    for (auto& readback : readbacks) {
+        readback.buffer = Buffer::New(
+            g_ctx.vk,
+            FrameExporter::frameSize(extent.width, extent.height),
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            true);
+        readback.pending = false;
+    }
+}
+
+void RecordExport::capture(Readback& readback, uint32_t swapchain_index)
+{
+    const auto& depth = attachments->getAttachment(attachment_descriptions["depth"].name);
+    depth.CopyTo(g_ctx.vk, readback.buffer, depth.extent, 0, { 0, 0, 0 }, size_t(depth.extent.width) * depth.extent.height * 4 * sizeof(float));
+    // copies the color to the front and makes both copies visible to the host
+    Record::capture(readback, swapchain_index);
+}
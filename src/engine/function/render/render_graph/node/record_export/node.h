@@ -0,0 +1,20 @@
+#pragma once
+
+#include "function/render/render_graph/node/recorder/node.h"
+
+// Record that reads back the HDR color and the depth attachment unconverted,
+// for the recorder to export them as image sequences. Each readback buffer
+// holds the color followed by the depth, see FrameExporter::frameSize.
+class RecordExport : public Record {
+protected:
+    void createBuffers() override;
+    void capture(Readback& readback, uint32_t swapchain_index) override;
+
+public:
+    RecordExport(
+        const std::string& name,
+        const std::string& color_buf_name,
+        const std::string& depth_buf_name);
+
+    virtual void init(Configuration& cfg, RenderAttachments& attachments) override;
+};
@@ -0,0 +1,137 @@
+#include "./node.h"
+#include "core/filesystem/file.h"
+#include "core/vulkan/vulkan_util.h"
+#include "function/global_context.h"
+#include "function/resource_manager/resource_manager.h"
+
+using namespace Vk;
+
+RecordYUV::RecordYUV(const std::string& name, const std::string& color_buf_name, bool tone_map)
+    : Record(name)
+    , tone_map(tone_map)
+{
+    attachment_descriptions = {
+        {
+            "color",
+            {
+                color_buf_name,
+                RenderAttachmentType::Color | RenderAttachmentType::Sampler,
+                RenderAttachmentRW::Read,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_IMAGE_USAGE_SAMPLED_BIT,
+                tone_map ? VK_FORMAT_R32G32B32A32_SFLOAT : VK_FORMAT_B8G8R8A8_UNORM,
+            },
+        },
+    };
+}
+
+void RecordYUV::init(Configuration& cfg, RenderAttachments& attachments)
+{
+    g_ctx.rm->recorder.input = Recorder::Input::YUV420;
+    Record::init(cfg, attachments);
+    createPipeline(cfg);
+}
+
+void RecordYUV::createBuffers()
+{
+    const auto& extent = g_ctx.vk.swapChainImages[0]->extent;
+    readbacks.resize(g_ctx.vk.framesInFlight);
+    for (auto& readback : readbacks) {
+        readback.buffer = Buffer::New(
+            g_ctx.vk,
+            Recorder::yuv420Size(extent.width, extent.height),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            true);
+        g_ctx.dm.registerResource(readback.buffer, DescriptorType::Storage);
+        readback.pending = false;
+    }
+}
+
+void RecordYUV::destroyBuffers()
+{
+    for (auto& readback : readbacks)
+        g_ctx.dm.removeResourceRegistration(readback.buffer);
+    Record::destroyBuffers();
+}
+
+void RecordYUV::fillParameters(Param& param, uint32_t slot)
+{
+    const auto& extent = g_ctx.vk.swapChainImages[0]->extent;
+    param.color_image = g_ctx.dm.getResourceHandle(
+        attachments->getAttachment(attachment_descriptions["color"].name).descriptor);
+    param.planes = g_ctx.dm.getResourceHandle(readbacks[slot].buffer.descriptor);
+    param.width = extent.width;
+    param.height = extent.height;
+    param.tone_map = tone_map ? 1 : 0;
+}
+
+void RecordYUV::createPipeline(Configuration& cfg)
+{
+    std::vector<VkDescriptorSetLayout> descLayouts = {
+        g_ctx.dm.BINDLESS_LAYOUT(),
+        g_ctx.uniforms.LAYOUT(),
+    };
+    pipeline.initLayout(descLayouts);
+
+    auto compShaderCode = readFile(cfg.shader_directory + "/record_yuv/node.comp.spv");
+    auto compShaderModule = createShaderModule(g_ctx.vk, compShaderCode);
+
+    VkComputePipelineCreateInfo pipelineInfo {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = Pipeline<Param>::shaderStageDefault(compShaderModule, VK_SHADER_STAGE_COMPUTE_BIT);
+    pipelineInfo.layout = pipeline.layout;
+    if (vkCreateComputePipelines(g_ctx.vk.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline.pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute pipeline!");
+    }
+    vkDestroyShaderModule(g_ctx.vk.device, compShaderModule, nullptr);
+
+    pipeline.initParameters([&](Param& param, uint32_t slot) {
+        fillParameters(param, slot);
+    });
+}
+
+void RecordYUV::capture(Readback& readback, uint32_t swapchain_index)
+{
+    VkCommandBuffer cmd = g_ctx.vk.commandBuffer;
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0, 1, g_ctx.dm.BINDLESS_SET(), 0, nullptr);
+    pipeline.bindParameters(cmd, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+    // one invocation per 8x2 block, 8x8 invocations per group
+    const auto& extent = g_ctx.vk.swapChainImages[0]->extent;
+    uint32_t blocks_x = (extent.width + 7) / 8;
+    uint32_t blocks_y = (extent.height + 1) / 2;
+    vkCmdDispatch(cmd, (blocks_x + 7) / 8, (blocks_y + 7) / 8, 1);
+
+    VkBufferMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = readback.buffer.buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        0, nullptr,
+        1, &barrier,
+        0, nullptr);
+}
+
+void RecordYUV::onResize()
+{
+    Record::onResize();
+    // the planes were reallocated and the attachment registered again
+    pipeline.refreshParameters();
+}
+
+void RecordYUV::destroy()
+{
+    pipeline.destroy();
+    Record::destroy();
+}
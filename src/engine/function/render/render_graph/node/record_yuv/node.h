@@ -0,0 +1,37 @@
+#pragma once
+
+#include "function/render/render_graph/node/recorder/node.h"
+
+// Record that converts the frame to YUV420 in a compute shader writing
+// straight into the readback buffers, 1.5 instead of 4 bytes per pixel. The
+// input is a sampled attachment, HDR input is tone mapped like HDRToSDR does.
+class RecordYUV : public Record {
+    struct Param {
+        Vk::DescriptorHandle color_image;
+        Vk::DescriptorHandle planes;
+        uint32_t width;
+        uint32_t height;
+        uint32_t tone_map;
+    };
+
+    void createPipeline(Configuration& cfg);
+    void fillParameters(Param& param, uint32_t slot);
+
+    Pipeline<Param> pipeline;
+    bool tone_map;
+
+protected:
+    void createBuffers() override;
+    void destroyBuffers() override;
+    void capture(Readback& readback, uint32_t swapchain_index) override;
+
+public:
+    RecordYUV(
+        const std::string& name,
+        const std::string& color_buf_name,
+        bool tone_map);
+
+    virtual void init(Configuration& cfg, RenderAttachments& attachments) override;
+    virtual void onResize() override;
+    virtual void destroy() override;
+};
@@ -2,6 +2,7 @@
 #include "core/vulkan/vulkan_util.h"
 #include "function/global_context.h"
 #include "function/resource_manager/resource_manager.h"
+#include <algorithm>
 
 using namespace Vk;
 
@@ -24,49 +25,129 @@ Record::Record(const std::string& name, const std::string& color_buf_name)
     };
 }
 
+Record::Record(const std::string& name)
+    : RenderGraphNode(name)
+{
+}
+
 void Record::init(Configuration& cfg, RenderAttachments& attachments)
 {
     this->attachments = &attachments;
-    createBuffer();
+    createBuffers();
+    g_ctx.rm->recorder.flush_pending = [this]() { flush(); };
 }
 
-void Record::createBuffer()
+void Record::createBuffers()
 {
     const auto& image = attachment_descriptions["color"].name == RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME()
         ? *g_ctx.vk.swapChainImages[0]
         : this->attachments->getAttachment(attachment_descriptions["color"].name);
 
-    buffer = Buffer::New(
-        g_ctx.vk,
-        image.size,
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        true);
+    readbacks.resize(g_ctx.vk.framesInFlight);
+    for (auto& readback : readbacks) {
+        readback.buffer = Buffer::New(
+            g_ctx.vk,
+            image.size,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            true);
+        readback.pending = false;
+    }
+}
 
-    data.resize(image.extent.width * image.extent.height * 4);
+void Record::destroyBuffers()
+{
+    for (auto& readback : readbacks)
+        Buffer::Delete(g_ctx.vk, readback.buffer);
+    readbacks.clear();
+}
+
+void Record::consume(Readback& readback)
+{
+    readback.pending = false;
+    g_ctx.rm->recorder.append(static_cast<const uint8_t*>(readback.buffer.mapped));
+}
+
+void Record::flush()
+{
+    // the copy of the frame being recorded right now isn't submitted yet
+    std::vector<Readback*> in_flight;
+    for (auto& readback : readbacks) {
+        if (readback.pending && readback.frame < g_ctx.currentFrame)
+            in_flight.emplace_back(&readback);
+        else
+            readback.pending = false;
+    }
+    std::sort(in_flight.begin(), in_flight.end(), [](const Readback* a, const Readback* b) {
+        return a->frame < b->frame;
+    });
+
+    for (auto* readback : in_flight) {
+        uint32_t slot = readback->frame % g_ctx.vk.framesInFlight;
+        vkWaitForFences(g_ctx.vk.device, 1, &g_ctx.vk.inFlightFences[slot], VK_TRUE, UINT64_MAX);
+        consume(*readback);
+    }
 }
 
 void Record::record(uint32_t swapchain_index)
 {
+    // the fence of the slot was waited on before recording, so its previous
+    // copy is complete
+    auto& readback = readbacks[g_ctx.frameSlot()];
+    if (readback.pending) {
+        if (g_ctx.rm->recorder.is_recording)
+            consume(readback);
+        readback.pending = false;
+    }
+
     if (g_ctx.rm->recorder.is_recording) {
-        const auto& image = attachment_descriptions["color"].name == RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME()
-            ? *g_ctx.vk.swapChainImages[swapchain_index]
-            : this->attachments->getAttachment(attachment_descriptions["color"].name);
+        capture(readback, swapchain_index);
+        readback.pending = true;
+        readback.frame = g_ctx.currentFrame;
+    }
+}
+
+void Record::capture(Readback& readback, uint32_t swapchain_index)
+{
+    const auto& image = attachment_descriptions["color"].name == RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME()
+        ? *g_ctx.vk.swapChainImages[swapchain_index]
+        : this->attachments->getAttachment(attachment_descriptions["color"].name);
 
-        image.CopyTo(g_ctx.vk, buffer, image.extent);
-        memcpy(data.data(), buffer.mapped, image.extent.width * image.extent.height * 4);
+    image.CopyTo(g_ctx.vk, readback.buffer, image.extent);
 
-        g_ctx.rm->recorder.append(data);
-    }
+    VkBufferMemoryBarrier barrier {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = readback.buffer.buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(
+        g_ctx.vk.commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        0, nullptr,
+        1, &barrier,
+        0, nullptr);
 }
 
 void Record::onResize()
 {
-    Buffer::Delete(g_ctx.vk, buffer);
-    createBuffer();
+    if (g_ctx.rm->recorder.is_recording)
+        flush();
+    destroyBuffers();
+    createBuffers();
 }
 
 void Record::destroy()
 {
-    Buffer::Delete(g_ctx.vk, buffer);
+    // the recorder only ends after the graph is gone, hand it the last frames
+    // while the buffers are still there
+    if (g_ctx.rm->recorder.is_recording)
+        flush();
+    g_ctx.rm->recorder.flush_pending = nullptr;
+    destroyBuffers();
 }
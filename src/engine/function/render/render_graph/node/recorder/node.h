@@ -4,12 +4,32 @@
 
 // left to right (width), top to bottom (height), B8G8R8A8_UINT8
 // brga, brga....
+//
+// The copy of frame n lands in the readback buffer of its frame slot and is
+// handed to the recorder when the slot comes around again, after its fence
+// signaled. Recording never waits on the GPU and lags framesInFlight frames.
 class Record : public RenderGraphNode {
-    Vk::Buffer buffer;
+protected:
+    struct Readback {
+        Vk::Buffer buffer;
+        bool pending = false;
+        uint32_t frame;
+    };
+    std::vector<Readback> readbacks;
     RenderAttachments* attachments;
-    std::vector<uint8_t> data;
 
-    void createBuffer();
+    // for derived nodes with their own attachment descriptions
+    Record(const std::string& name);
+    virtual void createBuffers();
+    virtual void destroyBuffers();
+    // records the commands writing the frame into the buffer of the readback,
+    // ending with a barrier to host reads
+    virtual void capture(Readback& readback, uint32_t swapchain_index);
+
+private:
+    void consume(Readback& readback);
+    // hands the copies still in flight to the recorder, oldest first
+    void flush();
 
 public:
     Record(
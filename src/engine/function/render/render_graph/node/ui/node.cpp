@@ -75,7 +75,7 @@ void UI::createRenderPass()
 
 void UI::record(uint32_t swapchain_index)
 {
-    setDefaultViewportAndScissor();
+    setDefaultViewportAndScissor(g_ctx.vk.commandBuffer);
 
     VkRenderPassBeginInfo renderPassInfo {};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -4,6 +4,7 @@
 #include "core/vulkan/vulkan_util.h"
 #include "function/global_context.h"
 #include "function/type/vertex.h"
+#include <functional>
 #include <vulkan/vulkan_core.h>
 
 #define VertexInputDefault(hasVertexInput)                                                                         \
@@ -55,8 +56,10 @@ template <typename T>
 struct Pipeline {
     VkPipelineLayout layout = VK_NULL_HANDLE;
     VkPipeline pipeline = VK_NULL_HANDLE;
-    T param;
-    Vk::Buffer param_buf;
+    // one per frame in flight as params may hold handles of per frame buffers,
+    // pushed to the uniform ring whenever the pipeline is bound
+    std::vector<T> params;
+    std::function<void(T&, uint32_t)> fill_parameters;
 
     void destroy()
     {
@@ -69,9 +72,30 @@ struct Pipeline {
         } else {
             assert(pipeline == VK_NULL_HANDLE);
         }
-        if (param_buf.id != uuid::nil_uuid()) {
-            Vk::Buffer::Delete(g_ctx.vk, param_buf);
-        }
+        params.clear();
+        fill_parameters = nullptr;
+    }
+
+    // fill sets up the params of the given frame slot
+    void initParameters(const std::function<void(T&, uint32_t)>& fill)
+    {
+        fill_parameters = fill;
+        refreshParameters();
+    }
+
+    // fills the params again, e.g. after the attachments were registered anew
+    void refreshParameters()
+    {
+        params.resize(g_ctx.vk.framesInFlight);
+        for (uint32_t slot = 0; slot < params.size(); slot++)
+            fill_parameters(params[slot], slot);
+    }
+
+    // binds the params of the current frame slot as set 1
+    void bindParameters(VkCommandBuffer cmd, VkPipelineBindPoint bind_point) const
+    {
+        uint32_t offset = g_ctx.uniforms.push(&params[g_ctx.frameSlot()], sizeof(T));
+        g_ctx.uniforms.bind(cmd, bind_point, layout, 1, offset);
     }
 
     static VkPipelineInputAssemblyStateCreateInfo inputAssemblyDefault()
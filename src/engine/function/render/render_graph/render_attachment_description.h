@@ -19,4 +19,9 @@ struct RenderAttachmentDescription {
     VkImageLayout layout;
     VkImageUsageFlags usage;
     VkFormat format;
+    // the node writes every texel, the previous contents are never needed
+    bool full_overwrite = false;
+    // set by the graph on the first user of an attachment, used by render
+    // passes in place of LOAD
+    VkAttachmentLoadOp load_op = VK_ATTACHMENT_LOAD_OP_LOAD;
 };
@@ -1,7 +1,10 @@
 #include "render_attachments.h"
+#include "core/tool/logger.h"
 #include "core/vulkan/type/image.h"
+#include "core/vulkan/vulkan_util.h"
 #include "function/global_context.h"
 #include "render_attachment_description.h"
+#include <algorithm>
 
 using namespace Vk;
 
@@ -23,25 +26,19 @@ VkImageAspectFlags RenderAttachments::getAspectFlags(RenderAttachmentType type)
     return aspectFlags;
 }
 
-void RenderAttachments::addAttachment(const std::string& name, RenderAttachmentType type, VkImageUsageFlags usage, VkFormat format)
+void RenderAttachments::addAttachment(const std::string& name, RenderAttachmentType type, VkImageUsageFlags usage, VkFormat format, uint32_t first_use, uint32_t last_use)
 {
     assert(name != RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME());
+    assert(first_use <= last_use);
     RenderAttachment attachment;
     attachment.name = name;
     attachment.type = type;
     attachment.usage = usage;
-    attachment.image = Image::New(
-        g_ctx.vk,
-        format,
-        g_ctx.vk.swapChainImages[0]->extent,
-        usage,
-        getAspectFlags(type),
-        VK_MEMORY_HEAP_DEVICE_LOCAL_BIT);
-    attachment.image.TransitionLayoutSingleTime(g_ctx.vk, VK_IMAGE_LAYOUT_GENERAL);
-    if (static_cast<uint8_t>(type & RenderAttachmentType::Sampler) != 0) {
-        attachment.image.AddDefaultSampler(g_ctx.vk);
-        g_ctx.dm.registerResource(attachment.image, DescriptorType::CombinedImageSampler);
-    }
+    attachment.first_use = first_use;
+    attachment.last_use = last_use;
+    attachment.image.format = format;
+    attachment.image.image = VK_NULL_HANDLE;
+    attachment.image.CreateUUID();
     attachments[name] = std::move(attachment);
 }
 
@@ -53,6 +50,111 @@ void RenderAttachments::removeAttachment(const std::string& name)
     attachments.erase(name);
 }
 
+void RenderAttachments::allocate()
+{
+    struct Placement {
+        RenderAttachment* attachment;
+        VkMemoryRequirements requirements;
+    };
+    std::vector<Placement> placements;
+    for (auto& a : attachments) {
+        auto& image = a.second.image;
+        image.extent = g_ctx.vk.swapChainImages[0]->extent;
+        image.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        VkImageCreateInfo imageInfo {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = image.extent;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = image.format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = a.second.usage;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateImage(g_ctx.vk.device, &imageInfo, nullptr, &image.image) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create image!");
+        }
+
+        Placement placement;
+        placement.attachment = &a.second;
+        vkGetImageMemoryRequirements(g_ctx.vk.device, image.image, &placement.requirements);
+        image.size = placement.requirements.size;
+        placements.emplace_back(placement);
+    }
+
+    // Greedy first fit, largest first: an attachment joins the first block
+    // whose users are all dead before it is written or born after it is last
+    // read. Every user is bound at offset 0.
+    std::sort(placements.begin(), placements.end(), [](const Placement& a, const Placement& b) {
+        return a.requirements.size > b.requirements.size;
+    });
+    struct Block {
+        VkMemoryRequirements requirements;
+        std::vector<RenderAttachment*> users;
+    };
+    std::vector<Block> blocks;
+    for (const auto& placement : placements) {
+        auto* attachment = placement.attachment;
+        auto fits = [&](const Block& block) {
+            if ((block.requirements.memoryTypeBits & placement.requirements.memoryTypeBits) == 0)
+                return false;
+            for (const auto* user : block.users) {
+                if (user->first_use <= attachment->last_use && attachment->first_use <= user->last_use)
+                    return false;
+            }
+            return true;
+        };
+        auto it = std::find_if(blocks.begin(), blocks.end(), fits);
+        if (it == blocks.end()) {
+            blocks.push_back({ placement.requirements, { attachment } });
+            continue;
+        }
+        it->requirements.size = std::max(it->requirements.size, placement.requirements.size);
+        it->requirements.alignment = std::max(it->requirements.alignment, placement.requirements.alignment);
+        it->requirements.memoryTypeBits &= placement.requirements.memoryTypeBits;
+        it->users.emplace_back(attachment);
+    }
+
+    VkDeviceSize requested = 0, allocated = 0;
+    for (const auto& block : blocks) {
+        VkMemoryAllocateInfo allocInfo {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = block.requirements.size;
+        allocInfo.memoryTypeIndex = findMemoryType(g_ctx.vk, block.requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        VkDeviceMemory memory;
+        if (vkAllocateMemory(g_ctx.vk.device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate attachment memory!");
+        }
+        memory_blocks.emplace_back(memory);
+        allocated += block.requirements.size;
+
+        for (auto* user : block.users) {
+            if (vkBindImageMemory(g_ctx.vk.device, user->image.image, memory, 0) != VK_SUCCESS) {
+                throw std::runtime_error("failed to bind attachment memory!");
+            }
+            requested += user->image.size;
+        }
+    }
+
+    for (auto& a : attachments) {
+        auto& image = a.second.image;
+        image.view = createImageView(g_ctx.vk, image.image, image.format, getAspectFlags(a.second.type));
+        image.sampler = VK_NULL_HANDLE;
+        if (static_cast<uint8_t>(a.second.type & RenderAttachmentType::Sampler) != 0) {
+            image.AddDefaultSampler(g_ctx.vk);
+            // the compiled graph transitions sampled attachments to
+            // SHADER_READ_ONLY_OPTIMAL before every read
+            g_ctx.dm.registerResource(image, DescriptorType::CombinedImageSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        }
+    }
+
+    INFO_ALL("Render attachments: {} images in {} memory blocks, {:.1f} MB allocated, {:.1f} MB saved by aliasing",
+        attachments.size(), blocks.size(), allocated / 1048576.0, (requested - allocated) / 1048576.0);
+}
+
 Vk::Image& RenderAttachments::getAttachment(const std::string& name)
 {
     assert(name != RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME());
@@ -62,33 +164,27 @@ Vk::Image& RenderAttachments::getAttachment(const std::string& name)
     }
     return it->second.image;
 }
+
+void RenderAttachments::releaseImages()
+{
+    for (auto& a : attachments)
+        a.second.destroy();
+    for (auto memory : memory_blocks)
+        vkFreeMemory(g_ctx.vk.device, memory, nullptr);
+    memory_blocks.clear();
+}
+
 void RenderAttachments::onResize()
 {
     for (auto& a : attachments) {
-        auto id = a.second.image.id;
         if (a.second.image.sampler != VK_NULL_HANDLE)
-            g_ctx.dm.removeResourceRegistration(id);
-        Image::Delete(g_ctx.vk, a.second.image);
-
-        a.second.image = Image::New(
-            g_ctx.vk,
-            a.second.image.format,
-            g_ctx.vk.swapChainImages[0]->extent,
-            a.second.usage,
-            getAspectFlags(a.second.type),
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-        a.second.image.TransitionLayoutSingleTime(g_ctx.vk, VK_IMAGE_LAYOUT_GENERAL);
-        a.second.image.id = id;
-        if (static_cast<uint8_t>(a.second.type & RenderAttachmentType::Sampler) != 0) {
-            a.second.image.AddDefaultSampler(g_ctx.vk);
-            g_ctx.dm.registerResource(a.second.image, DescriptorType::CombinedImageSampler);
-        }
+            g_ctx.dm.removeResourceRegistration(a.second.image);
     }
+    releaseImages();
+    allocate();
 }
 
 void RenderAttachments::cleanup()
 {
-    for (auto& a : attachments) {
-        a.second.destroy();
-    }
+    releaseImages();
 }
@@ -4,6 +4,7 @@
 #include "core/vulkan/type/image.h"
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 enum class RenderAttachmentType : uint8_t {
     Color = 1 << 0,
@@ -18,17 +19,31 @@ struct RenderAttachment {
     Vk::Image image;
     VkImageUsageFlags usage;
     RenderAttachmentType type;
+    // indices of the first and last node using the attachment in execution
+    // order, the contents are only defined in between
+    uint32_t first_use;
+    uint32_t last_use;
+    // cleared by transfer commands in front of the first user, unless that
+    // one clears on load or overwrites everything
+    bool needs_clear = true;
     void destroy();
 };
 
 class RenderAttachments {
     static VkImageAspectFlags getAspectFlags(RenderAttachmentType type);
+    void releaseImages();
+
+    // Attachments with disjoint lifetimes are bound to the same block, the
+    // images don't own their memory.
+    std::vector<VkDeviceMemory> memory_blocks;
 
 public:
     // you need to specify the complete type and usage.
     // type can't only be sampler.
-    void addAttachment(const std::string& name, RenderAttachmentType type, VkImageUsageFlags usage, VkFormat format);
+    void addAttachment(const std::string& name, RenderAttachmentType type, VkImageUsageFlags usage, VkFormat format, uint32_t first_use, uint32_t last_use);
     void removeAttachment(const std::string& name);
+    // creates the images of all added attachments and places them in memory
+    void allocate();
     Vk::Image& getAttachment(const std::string& name);
     void onResize();
 
@@ -1,37 +1,13 @@
 #include "render_graph.h"
+#include "core/tool/tracer.h"
+#include "core/vulkan/vulkan_util.h"
 #include <queue>
 
-void RenderGraph::clearAttachments()
+static bool isRenderTarget(const RenderAttachmentDescription& desc)
 {
-    for (auto& attachment : attachments.attachments) {
-        auto layout = attachment.second.image.layout;
-        attachment.second.image.TransitionLayout(g_ctx.vk, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-        VkImageSubresourceRange range = {};
-        range.baseMipLevel = 0;
-        range.levelCount = 1;
-        range.baseArrayLayer = 0;
-        range.layerCount = 1;
-        if (static_cast<uint8_t>(attachment.second.type & RenderAttachmentType::Color) != 0) {
-            VkClearColorValue clearColor = {};
-            clearColor = { { 0.0f, 0.0f, 0.0f, 1.0f } };
-            range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            vkCmdClearColorImage(
-                g_ctx.vk.commandBuffer,
-                attachment.second.image.image,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &range);
-        }
-        if (static_cast<uint8_t>(attachment.second.type & RenderAttachmentType::Depth) != 0) {
-            VkClearDepthStencilValue clearValue = {};
-            clearValue = { 1.0f, 0 };
-            range.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-            vkCmdClearDepthStencilImage(
-                g_ctx.vk.commandBuffer,
-                attachment.second.image.image,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearValue, 1, &range);
-        }
-        attachment.second.image.TransitionLayout(g_ctx.vk, layout);
-    }
+    return static_cast<uint8_t>(desc.rw & RenderAttachmentRW::Write) != 0
+        && (desc.layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+            || desc.layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
 }
 
 void RenderGraph::initGraph()
@@ -49,20 +25,46 @@ void RenderGraph::initGraph()
             starting_nodes.emplace_back(node.first);
         }
     }
+
+    order.clear();
+    auto degree = in_degree;
+    std::queue<std::string> queue;
+    for (const auto& node : starting_nodes) {
+        queue.emplace(node);
+    }
+    while (!queue.empty()) {
+        std::string name = queue.front();
+        queue.pop();
+        degree[name] = -1;
+        order.emplace_back(name);
+
+        for (const auto& next_node : rev_graph[name]) {
+            if (degree[next_node] == -1)
+                continue;
+            degree[next_node]--;
+            if (degree[next_node] == 0) {
+                queue.emplace(next_node);
+            }
+        }
+    }
+    assert(order.size() == nodes.size());
 }
 
 void RenderGraph::initAttachments()
 {
     std::unordered_map<std::string, RenderAttachmentDescription> descriptions;
-    for (const auto& node : nodes) {
-        for (auto& desc_pair : node.second->attachment_descriptions) {
+    std::unordered_map<std::string, std::pair<uint32_t, uint32_t>> lifetimes;
+    for (uint32_t i = 0; i < order.size(); i++) {
+        for (auto& desc_pair : nodes[order[i]]->attachment_descriptions) {
             if (desc_pair.second.name == RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME())
                 continue;
 
             auto it = descriptions.find(desc_pair.second.name);
             if (it == descriptions.end()) {
                 descriptions[desc_pair.second.name] = desc_pair.second;
+                lifetimes[desc_pair.second.name] = { i, i };
             } else {
+                lifetimes[desc_pair.second.name].second = i;
                 assert(it->second.format == desc_pair.second.format);
                 it->second.usage |= desc_pair.second.usage;
                 it->second.type = it->second.type | desc_pair.second.type;
@@ -71,22 +73,250 @@ void RenderGraph::initAttachments()
         }
     }
     for (const auto& desc : descriptions) {
-        attachments.addAttachment(desc.first, desc.second.type, desc.second.usage, desc.second.format);
+        const auto& lifetime = lifetimes[desc.first];
+        attachments.addAttachment(
+            desc.first,
+            desc.second.type,
+            desc.second.usage,
+            desc.second.format,
+            lifetime.first,
+            lifetime.second);
+
+        // the first user starts from undefined contents
+        for (auto& desc_pair : nodes[order[lifetime.first]]->attachment_descriptions) {
+            auto& first = desc_pair.second;
+            if (first.name != desc.first)
+                continue;
+            if (first.full_overwrite)
+                first.load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            else if (isRenderTarget(first))
+                first.load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            attachments.attachments[desc.first].needs_clear = first.load_op == VK_ATTACHMENT_LOAD_OP_LOAD;
+        }
+    }
+    attachments.allocate();
+}
+
+void RenderGraph::initSecondaryRecording(uint32_t thread_count)
+{
+    if (thread_count == 0)
+        return;
+
+    record_pool = std::make_unique<ThreadPool>(thread_count);
+    for (const auto& node : nodes) {
+        if (!node.second->recordsContents())
+            continue;
+
+        auto& commands = secondary_commands[node.first];
+        commands.pools.resize(g_ctx.vk.framesInFlight);
+        commands.buffers.resize(g_ctx.vk.framesInFlight);
+        for (uint32_t slot = 0; slot < g_ctx.vk.framesInFlight; slot++) {
+            VkCommandPoolCreateInfo poolInfo {};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+            poolInfo.queueFamilyIndex = g_ctx.vk.queueFamilyIndices.graphicsFamily.value();
+            if (vkCreateCommandPool(g_ctx.vk.device, &poolInfo, nullptr, &commands.pools[slot]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create command pool!");
+            }
+
+            VkCommandBufferAllocateInfo allocInfo {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = commands.pools[slot];
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(g_ctx.vk.device, &allocInfo, &commands.buffers[slot]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate command buffers!");
+            }
+        }
     }
 }
 
-void RenderGraph::prepareAttachmentsForNode(const auto& node, uint32_t swapchain_index)
+void RenderGraph::compile()
 {
-    for (const auto& desc_pair : node->attachment_descriptions) {
-        auto& image = desc_pair.second.name == RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME()
-            ? *g_ctx.vk.swapChainImages[swapchain_index]
-            : attachments.getAttachment(desc_pair.second.name);
-        if (image.layout == swapchain_index)
+    compiled_nodes.clear();
+    for (const auto& name : order) {
+        CompiledNode compiled;
+        compiled.node = nodes[name].get();
+        compiled.profile_scope = g_ctx.gpu_profiler.scope(name);
+        auto it = secondary_commands.find(name);
+        if (it != secondary_commands.end())
+            compiled.secondary = &it->second;
+        compiled_nodes.emplace_back(std::move(compiled));
+    }
+
+    uint32_t job_count = 0;
+    record_job_index.assign(compiled_nodes.size(), -1);
+    for (size_t i = 0; i < compiled_nodes.size(); i++) {
+        if (compiled_nodes[i].secondary != nullptr)
+            record_job_index[i] = static_cast<int32_t>(job_count++);
+    }
+    record_jobs = std::make_unique<RecordJob[]>(job_count);
+    for (size_t i = 0; i < compiled_nodes.size(); i++) {
+        if (record_job_index[i] >= 0)
+            record_jobs[record_job_index[i]].compiled = &compiled_nodes[i];
+    }
+    record_batch.count = job_count;
+    record_batch.fn = [this](uint32_t index) {
+        auto& job = record_jobs[index];
+        try {
+            job.cmd = recordSecondary(*job.compiled, record_swapchain_index);
+        } catch (...) {
+            job.error = std::current_exception();
+        }
+        job.recorded.store(true, std::memory_order_release);
+        job.recorded.notify_one();
+    };
+
+    // Attachment contents don't survive their lifetime, every frame starts
+    // them from UNDEFINED. Swapchain images start and end in the output
+    // layout, bring them there once so the plan holds from the first frame on.
+    std::unordered_map<Vk::Image*, VkImageLayout> frame_layouts;
+    for (auto& attachment : attachments.attachments) {
+        frame_layouts[&attachment.second.image] = VK_IMAGE_LAYOUT_UNDEFINED;
+        if (!attachment.second.needs_clear)
             continue;
-        image.TransitionLayout(g_ctx.vk, desc_pair.second.layout);
+        auto& compiled = compiled_nodes[attachment.second.first_use];
+        compiled.clears.emplace_back(&attachment.second);
+        addTransition(
+            compiled.clear_barriers,
+            attachment.second.image,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    }
+    for (auto& image : g_ctx.vk.swapChainImages) {
+        if (image->layout != g_ctx.vk.outputLayout)
+            image->TransitionLayoutSingleTime(g_ctx.vk, g_ctx.vk.outputLayout);
+    }
+
+    const size_t swapchain_count = g_ctx.vk.swapChainImages.size();
+    present_barriers.assign(swapchain_count, {});
+    for (auto& compiled : compiled_nodes)
+        compiled.barriers.assign(swapchain_count, {});
+
+    for (size_t swapchain_index = 0; swapchain_index < swapchain_count; swapchain_index++) {
+        auto& swapchain_image = *g_ctx.vk.swapChainImages[swapchain_index];
+        auto layouts = frame_layouts;
+        layouts[&swapchain_image] = g_ctx.vk.outputLayout;
+
+        for (auto& compiled : compiled_nodes) {
+            for (auto* attachment : compiled.clears)
+                layouts[&attachment->image] = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            for (const auto& desc : compiled.node->attachment_descriptions) {
+                auto& image = desc.second.name == RenderAttachmentDescription::SWAPCHAIN_IMAGE_NAME()
+                    ? swapchain_image
+                    : attachments.getAttachment(desc.second.name);
+                auto& layout = layouts[&image];
+                if (layout == desc.second.layout)
+                    continue;
+                addTransition(compiled.barriers[swapchain_index], image, layout, desc.second.layout);
+                layout = desc.second.layout;
+            }
+        }
+        if (layouts[&swapchain_image] != g_ctx.vk.outputLayout) {
+            addTransition(
+                present_barriers[swapchain_index],
+                swapchain_image,
+                layouts[&swapchain_image],
+                g_ctx.vk.outputLayout);
+        }
     }
 }
 
+void RenderGraph::addTransition(CompiledBarriers& transitions, Vk::Image& image, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+    VkImageMemoryBarrier barrier;
+    VkPipelineStageFlags srcStage, dstStage;
+    Vk::imageLayoutBarrier(image.image, image.format, oldLayout, newLayout, barrier, srcStage, dstStage);
+    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED) {
+        srcStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    }
+    transitions.src_stage |= srcStage;
+    transitions.dst_stage |= dstStage;
+    transitions.barriers.emplace_back(barrier);
+    transitions.layouts.emplace_back(&image, newLayout);
+}
+
+void RenderGraph::recordBarriers(const CompiledBarriers& transitions)
+{
+    if (transitions.barriers.empty())
+        return;
+
+    for (const auto& [image, layout] : transitions.layouts)
+        image->layout = layout;
+    vkCmdPipelineBarrier(
+        g_ctx.vk.commandBuffer,
+        transitions.src_stage,
+        transitions.dst_stage,
+        0,
+        0, nullptr,
+        0, nullptr,
+        transitions.barriers.size(), transitions.barriers.data());
+}
+
+void RenderGraph::recordClears(const CompiledNode& compiled)
+{
+    if (compiled.clears.empty())
+        return;
+
+    recordBarriers(compiled.clear_barriers);
+    for (const auto* attachment : compiled.clears) {
+        VkImageSubresourceRange range = {};
+        range.baseMipLevel = 0;
+        range.levelCount = 1;
+        range.baseArrayLayer = 0;
+        range.layerCount = 1;
+        if (static_cast<uint8_t>(attachment->type & RenderAttachmentType::Color) != 0) {
+            VkClearColorValue clearColor = {};
+            clearColor = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+            range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            vkCmdClearColorImage(
+                g_ctx.vk.commandBuffer,
+                attachment->image.image,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &range);
+        }
+        if (static_cast<uint8_t>(attachment->type & RenderAttachmentType::Depth) != 0) {
+            VkClearDepthStencilValue clearValue = {};
+            clearValue = { 1.0f, 0 };
+            range.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+            vkCmdClearDepthStencilImage(
+                g_ctx.vk.commandBuffer,
+                attachment->image.image,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearValue, 1, &range);
+        }
+    }
+}
+
+VkCommandBuffer RenderGraph::recordSecondary(const CompiledNode& compiled, uint32_t swapchain_index)
+{
+    PROFILE_SCOPE("recordSecondary");
+    uint32_t slot = g_ctx.frameSlot();
+    vkResetCommandPool(g_ctx.vk.device, compiled.secondary->pools[slot], 0);
+    VkCommandBuffer cmd = compiled.secondary->buffers[slot];
+
+    auto begin = compiled.node->renderPassBegin(swapchain_index);
+    VkCommandBufferInheritanceInfo inheritanceInfo {};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = begin.render_pass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = begin.framebuffer;
+
+    VkCommandBufferBeginInfo beginInfo {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording command buffer!");
+    }
+
+    compiled.node->recordContents(cmd, swapchain_index);
+
+    if (vkEndCommandBuffer(cmd) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+    return cmd;
+}
+
 void RenderGraph::record(uint32_t swapchain_index)
 {
     VkCommandBufferBeginInfo beginInfo {};
@@ -96,35 +326,46 @@ void RenderGraph::record(uint32_t swapchain_index)
     if (vkBeginCommandBuffer(g_ctx.vk.commandBuffer, &beginInfo) != VK_SUCCESS) {
         throw std::runtime_error("failed to begin recording command buffer!");
     }
+    g_ctx.gpu_profiler.beginFrame(g_ctx.vk.commandBuffer, g_ctx.frameSlot());
 
-    clearAttachments();
-
-    auto degree = in_degree;
-    std::queue<std::string> queue;
-    for (const auto& node : starting_nodes) {
-        queue.emplace(node);
-    }
-    while (!queue.empty()) {
-        std::string name = queue.front();
-        auto& node = nodes[name];
-        queue.pop();
-        degree[name] = -1;
-
-        {
-            prepareAttachmentsForNode(node, swapchain_index);
-            node->record(swapchain_index);
+    // Contents of all capable nodes are recorded up front on the workers and
+    // stitched into the primary buffer in dependency order. Inline nodes run
+    // on this thread only after every node before them finished recording.
+    if (record_pool) {
+        for (uint32_t i = 0; i < record_batch.count; i++) {
+            record_jobs[i].error = nullptr;
+            record_jobs[i].recorded.store(false, std::memory_order_relaxed);
         }
+        record_swapchain_index = swapchain_index;
+        record_pool->run(record_batch);
+    }
 
-        for (const auto& next_node : rev_graph[name]) {
-            if (degree[next_node] == -1)
-                continue;
-            degree[next_node]--;
-            if (degree[next_node] == 0) {
-                queue.emplace(next_node);
+    for (size_t i = 0; i < compiled_nodes.size(); i++) {
+        const auto& compiled = compiled_nodes[i];
+        g_ctx.gpu_profiler.beginScope(g_ctx.vk.commandBuffer, compiled.profile_scope);
+        recordClears(compiled);
+        recordBarriers(compiled.barriers[swapchain_index]);
+        if (record_job_index[i] >= 0) {
+            auto& job = record_jobs[record_job_index[i]];
+            job.recorded.wait(false, std::memory_order_acquire);
+            if (job.error) {
+                // the jobs still running use this frame's command buffers
+                ThreadPool::wait(record_batch);
+                std::rethrow_exception(job.error);
             }
+            compiled.node->beginRenderPass(g_ctx.vk.commandBuffer, swapchain_index, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            vkCmdExecuteCommands(g_ctx.vk.commandBuffer, 1, &job.cmd);
+            vkCmdEndRenderPass(g_ctx.vk.commandBuffer);
+        } else {
+            compiled.node->record(swapchain_index);
         }
+        g_ctx.gpu_profiler.endScope(g_ctx.vk.commandBuffer, compiled.profile_scope);
     }
-    g_ctx.vk.swapChainImages[swapchain_index]->TransitionLayout(g_ctx.vk, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    recordBarriers(present_barriers[swapchain_index]);
+    // every job was consumed above, this only waits for the workers to let
+    // go of the batch before it runs again
+    if (record_pool)
+        ThreadPool::wait(record_batch);
 
     if (vkEndCommandBuffer(g_ctx.vk.commandBuffer) != VK_SUCCESS) {
         throw std::runtime_error("failed to record command buffer!");
@@ -137,10 +378,18 @@ void RenderGraph::onResize()
     for (auto& node : nodes) {
         node.second->onResize();
     }
+    compile();
 }
 
 void RenderGraph::destroy()
 {
+    record_pool.reset();
+    for (auto& commands : secondary_commands) {
+        for (auto& pool : commands.second.pools)
+            vkDestroyCommandPool(g_ctx.vk.device, pool, nullptr);
+    }
+    secondary_commands.clear();
+
     for (auto& node : nodes)
         node.second->destroy();
     attachments.cleanup();
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "core/tool/thread_pool.h"
 #include "function/render/render_graph/node/node.h"
 #include "function/render/render_graph/render_attachments.h"
 #include "function/render/render_graph/render_graph_node.h"
+#include <atomic>
+#include <exception>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -19,11 +22,69 @@ protected:
     std::unordered_map<std::string, std::vector<std::string>> rev_graph;
     std::unordered_map<std::string, int> in_degree;
     std::vector<std::string> starting_nodes;
+    // execution order, dependencies first
+    std::vector<std::string> order;
+
+    // Nodes that record their contents get secondary command buffers, with a
+    // pool per node and frame slot so that workers never share a pool.
+    struct SecondaryCommands {
+        std::vector<VkCommandPool> pools;
+        std::vector<VkCommandBuffer> buffers;
+    };
+    std::unordered_map<std::string, SecondaryCommands> secondary_commands;
+    std::unique_ptr<ThreadPool> record_pool;
+
+    // Execution plan built by compile: the nodes in dependency order and, per
+    // swapchain image, the merged layout transitions in front of each node.
+    // Attachments may share memory, so their contents are undefined until the
+    // first user clears them on load. Attachments first sampled instead are
+    // cleared by transfer commands in front of it.
+    struct CompiledBarriers {
+        VkPipelineStageFlags src_stage = 0;
+        VkPipelineStageFlags dst_stage = 0;
+        std::vector<VkImageMemoryBarrier> barriers;
+        // host side layout tracking, applied along with the barriers
+        std::vector<std::pair<Vk::Image*, VkImageLayout>> layouts;
+    };
+    struct CompiledNode {
+        RenderGraphNode* node;
+        SecondaryCommands* secondary = nullptr;
+        CompiledBarriers clear_barriers;
+        std::vector<RenderAttachment*> clears;
+        std::vector<CompiledBarriers> barriers;
+        // GPU timestamps around the clears, barriers and the node itself
+        uint32_t profile_scope;
+    };
+    std::vector<CompiledNode> compiled_nodes;
+    std::vector<CompiledBarriers> present_barriers;
+
+    // One job per node with secondary commands, built by compile so that
+    // recording a frame allocates nothing.
+    struct RecordJob {
+        const CompiledNode* compiled;
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        std::exception_ptr error;
+        std::atomic<bool> recorded = false;
+    };
+    std::unique_ptr<RecordJob[]> record_jobs;
+    // job per compiled node, -1 for nodes recorded inline
+    std::vector<int32_t> record_job_index;
+    ThreadPool::Batch record_batch;
+    uint32_t record_swapchain_index = 0;
 
-    virtual void clearAttachments();
     void initGraph();
-    void prepareAttachmentsForNode(const auto& node, uint32_t swapchain_index);
+    // after initGraph, the lifetimes follow its execution order
     void initAttachments();
+    // after the nodes were initialized, 0 threads records everything inline
+    void initSecondaryRecording(uint32_t thread_count);
+    // after initGraph and initSecondaryRecording, again whenever images change
+    void compile();
+    // transitions from UNDEFINED wait for everything before, as the memory
+    // may have been used by another attachment
+    static void addTransition(CompiledBarriers& transitions, Vk::Image& image, VkImageLayout oldLayout, VkImageLayout newLayout);
+    void recordBarriers(const CompiledBarriers& transitions);
+    void recordClears(const CompiledNode& compiled);
+    VkCommandBuffer recordSecondary(const CompiledNode& compiled, uint32_t swapchain_index);
 
 public:
     virtual ~RenderGraph() = default;
@@ -17,7 +17,9 @@ VkRenderPass RenderGraphNode::DefaultRenderPass(
             {
                 .format = attachment_descriptions[d.name].format,
                 .samples = VK_SAMPLE_COUNT_1_BIT,
-                .loadOp = static_cast<VkAttachmentLoadOp>(d.load_op),
+                .loadOp = d.load_op == VK_ATTACHMENT_LOAD_OP_LOAD
+                    ? attachment_descriptions[d.name].load_op
+                    : d.load_op,
                 .storeOp = static_cast<VkAttachmentStoreOp>(d.store_op),
                 .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
                 .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
@@ -67,10 +69,32 @@ VkRenderPass RenderGraphNode::DefaultRenderPass(
     return render_pass;
 }
 
-void RenderGraphNode::bindDescriptorSet(uint32_t index, VkPipelineLayout layout, VkDescriptorSet* set)
+void RenderGraphNode::record(uint32_t swapchain_index)
+{
+    assert(recordsContents());
+    beginRenderPass(g_ctx.vk.commandBuffer, swapchain_index, VK_SUBPASS_CONTENTS_INLINE);
+    recordContents(g_ctx.vk.commandBuffer, swapchain_index);
+    vkCmdEndRenderPass(g_ctx.vk.commandBuffer);
+}
+
+void RenderGraphNode::beginRenderPass(VkCommandBuffer cmd, uint32_t swapchain_index, VkSubpassContents contents)
+{
+    auto begin = renderPassBegin(swapchain_index);
+    VkRenderPassBeginInfo renderPassInfo {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = begin.render_pass;
+    renderPassInfo.framebuffer = begin.framebuffer;
+    renderPassInfo.renderArea.offset = { 0, 0 };
+    renderPassInfo.renderArea.extent = Vk::toVkExtent2D(g_ctx.vk.swapChainImages[swapchain_index]->extent);
+    renderPassInfo.clearValueCount = begin.clear_values.size();
+    renderPassInfo.pClearValues = begin.clear_values.data();
+    vkCmdBeginRenderPass(cmd, &renderPassInfo, contents);
+}
+
+void RenderGraphNode::bindDescriptorSet(VkCommandBuffer cmd, uint32_t index, VkPipelineLayout layout, VkDescriptorSet* set)
 {
     vkCmdBindDescriptorSets(
-        g_ctx.vk.commandBuffer,
+        cmd,
         VK_PIPELINE_BIND_POINT_GRAPHICS,
         layout,
         index,
@@ -80,7 +104,7 @@ void RenderGraphNode::bindDescriptorSet(uint32_t index, VkPipelineLayout layout,
         nullptr);
 }
 
-void RenderGraphNode::setDefaultViewportAndScissor()
+void RenderGraphNode::setDefaultViewportAndScissor(VkCommandBuffer cmd)
 {
     VkViewport viewport {};
     viewport.x = 0.0f;
@@ -89,9 +113,9 @@ void RenderGraphNode::setDefaultViewportAndScissor()
     viewport.height = static_cast<float>(g_ctx.vk.swapChainImages[0]->extent.height);
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(g_ctx.vk.commandBuffer, 0, 1, &viewport);
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
     VkRect2D scissor {};
     scissor.offset = { 0, 0 };
     scissor.extent = Vk::toVkExtent2D(g_ctx.vk.swapChainImages[0]->extent);
-    vkCmdSetScissor(g_ctx.vk.commandBuffer, 0, 1, &scissor);
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
 }
@@ -11,6 +11,7 @@ class RenderGraphNode {
 protected:
     struct AttachmentDescriptionHelper {
         std::string name;
+        // LOAD defers to the load_op the graph resolved for the attachment
         VkAttachmentLoadOp load_op;
         VkAttachmentStoreOp store_op;
     };
@@ -18,16 +19,30 @@ protected:
         std::unordered_map<std::string, RenderAttachmentDescription>& attachment_descriptions,
         const std::vector<AttachmentDescriptionHelper>& desc,
         VkSubpassDependency& dependency);
-    void bindDescriptorSet(uint32_t index, VkPipelineLayout layout, VkDescriptorSet* set);
-    void setDefaultViewportAndScissor();
+    void bindDescriptorSet(VkCommandBuffer cmd, uint32_t index, VkPipelineLayout layout, VkDescriptorSet* set);
+    void setDefaultViewportAndScissor(VkCommandBuffer cmd);
 
 public:
+    struct RenderPassBegin {
+        VkRenderPass render_pass = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        std::vector<VkClearValue> clear_values;
+    };
+
     // init the descriptrion directly in the derived class
     RenderGraphNode(const std::string& name);
     virtual ~RenderGraphNode() = default;
 
     virtual void init(Configuration& cfg, RenderAttachments& attachments) = 0;
-    virtual void record(uint32_t swapchain_index) = 0;
+    // Nodes either override record, or return true from recordsContents and
+    // describe their render pass with renderPassBegin. recordContents then
+    // records everything inside the pass, possibly into a secondary command
+    // buffer on a worker thread, so it must only read shared state.
+    virtual void record(uint32_t swapchain_index);
+    virtual bool recordsContents() const { return false; }
+    virtual RenderPassBegin renderPassBegin(uint32_t swapchain_index) { return {}; }
+    virtual void recordContents(VkCommandBuffer cmd, uint32_t swapchain_index) { }
+    void beginRenderPass(VkCommandBuffer cmd, uint32_t swapchain_index, VkSubpassContents contents);
     virtual void onResize() = 0;
     virtual void destroy() = 0;
 
@@ -33,6 +33,19 @@ vec3 srgbToLinear(vec3 v)
     return pow(v, vec3(gamma));
 }
 
+// ACES filmic fit
+vec3 toneRemap(vec3 color)
+{
+    float a = 2.51f;
+    float b = 0.03f;
+    float c = 2.43f;
+    float d = 0.59f;
+    float e = 0.14f;
+    color = (color * (a * color + b)) / (color * (c * color + d) + e);
+
+    return color;
+}
+
 bool selectPixel(int i, int j, vec4 GL_FragCoord)
 {
     return GL_FragCoord.x > i && GL_FragCoord.y > j && GL_FragCoord.x <= i + 1 && GL_FragCoord.y <= j + 1;
@@ -1,10 +1,12 @@
 #include "resource_manager.h"
+#include "core/tool/tracer.h"
 #include "function/global_context.h"
 
 using namespace Vk;
 
 void ResourceManager::load(Configuration& config)
 {
+    PROFILE_SCOPE("ResourceManager::load");
     camera = Camera::fromConfiguration(config.camera);
     lights = Lights::fromConfiguration(config.lights);
 
@@ -24,7 +26,7 @@ void ResourceManager::load(Configuration& config)
         materials[material.name] = material;
     }
 
-    fields = Fields::fromConfiguration(config.fields);
+    fields = Fields::fromConfiguration(config.fields, config.frame_pipeline.double_buffered_fields);
 
     for (auto& cfg : config.objects) {
         objects.emplace_back(Object::fromConfiguration(cfg));
@@ -33,6 +35,17 @@ void ResourceManager::load(Configuration& config)
     recorder.init(config);
 }
 
+void ResourceManager::flushFrameData(uint32_t slot)
+{
+    camera.buffer.Flush(slot);
+    lights.buffer.Flush(slot);
+    for (auto& mat : materials) {
+        mat.second.buffer.Flush(slot);
+    }
+    if (fields.has_temperature)
+        fields.lights.buffer.Flush(slot);
+}
+
 void ResourceManager::cleanup()
 {
     recorder.destroy();
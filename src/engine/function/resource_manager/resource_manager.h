@@ -24,6 +24,8 @@ public:
     Recorder recorder;
 
     void load(Configuration& config);
+    // copies host side changes into the buffers read by the frame in slot
+    void flushFrameData(uint32_t slot);
     void cleanup();
 
 private:
@@ -0,0 +1,43 @@
+#include "field_budget.h"
+#include "function/global_context.h"
+#include "function/resource_manager/resource_manager.h"
+#include <algorithm>
+#include <cmath>
+
+void FieldBudget::init(const FieldBudgetConfiguration& config)
+{
+    enabled = config.enabled && g_ctx.gpu_profiler.enabled();
+    node = config.node;
+    target_frame_ms = config.target_frame_ms;
+    min_step_scale = config.min_step_scale;
+    max_step_scale = config.max_step_scale;
+    g_ctx.rm->fields.step_scale = 1.0f;
+}
+
+void FieldBudget::update()
+{
+    if (!enabled || ++frames_since_change < SETTLE_FRAMES)
+        return;
+
+    const auto& timings = g_ctx.gpu_profiler.timings();
+    auto it = std::find_if(timings.begin(), timings.end(), [&](const auto& t) { return t.name == node; });
+    if (it == timings.end() || it->average_ms <= 0.0f)
+        return;
+
+    // everything else in the frame is taken as fixed, both averaged the same
+    // way so a single slow frame doesn't move the step
+    float other_ms = std::max(0.0f, g_ctx.gpu_profiler.frameAverageMs() - it->average_ms);
+    float budget_ms = std::max(target_frame_ms - other_ms, 0.1f * target_frame_ms);
+    float ratio = it->average_ms / budget_ms;
+    // dead band against oscillating around the target
+    if (ratio > 0.9f && ratio < 1.05f)
+        return;
+
+    auto& scale = g_ctx.rm->fields.step_scale;
+    // halfway towards the estimate in log space to damp overshooting
+    float next = std::clamp(scale * std::sqrt(ratio), min_step_scale, max_step_scale);
+    if (next != scale) {
+        scale = next;
+        frames_since_change = 0;
+    }
+}
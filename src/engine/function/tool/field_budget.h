@@ -0,0 +1,26 @@
+#pragma once
+
+#include "core/config/config.h"
+#include <string>
+
+// Scales the ray marching step of the field pass so the GPU frame time stays
+// near a target. The field cost is roughly inverse to the step, so the scale
+// follows the ratio of the field time to what the budget leaves for it.
+class FieldBudget {
+public:
+    void init(const FieldBudgetConfiguration& config);
+    // call once per frame, reads the timings of the GPU profiler
+    void update();
+
+private:
+    // The timings lag behind by the frames in flight and the moving average
+    // of the profiler, give them time to show a change before the next one.
+    static constexpr uint32_t SETTLE_FRAMES = 30;
+
+    bool enabled = false;
+    std::string node;
+    float target_frame_ms;
+    float min_step_scale;
+    float max_step_scale;
+    uint32_t frames_since_change = 0;
+};
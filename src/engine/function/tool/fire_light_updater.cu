@@ -2,6 +2,7 @@
 #include "core/tool/npy.hpp"
 #include "fire_light_updater.h"
 #include "function/type/light.h"
+#include <algorithm>
 #include <cuda.h>
 #include <cuda_runtime.h>
 
@@ -34,10 +35,19 @@ void FireLightsUpdater::init(const FieldsConfiguration& config)
     loadFireColorTexture(config.fire_configuration.fire_colors_path);
 
     cudaMalloc(&d_out_intensities, sample_dim.x * sample_dim.y * sample_dim.z * sizeof(glm::vec3));
+    cudaMemset(d_out_intensities, 0, sample_dim.x * sample_dim.y * sample_dim.z * sizeof(glm::vec3));
     out_intensities.resize(sample_dim.x * sample_dim.y * sample_dim.z);
+    cudaMallocHost(&h_intensities, sample_dim.x * sample_dim.y * sample_dim.z * sizeof(glm::vec3));
+    cudaEventCreateWithFlags(&download_done, cudaEventDisableTiming);
+    download_pending = false;
 
-    light_sample_gain = config.fire_configuration.light_sample_gain;
-    cudaMemcpyToSymbol(light_sample_gain, &light_sample_gain, sizeof(float));
+    // an interval above the cell count would leave phases without any cell
+    update_interval = std::clamp(config.fire_configuration.light_update_interval, 1, sample_dim.x * sample_dim.y * sample_dim.z);
+    smoothing = config.fire_configuration.light_smoothing;
+    update_count = 0;
+
+    sample_gain = config.fire_configuration.light_sample_gain;
+    cudaMemcpyToSymbol(light_sample_gain, &sample_gain, sizeof(float));
 }
 
 void FireLightsUpdater::loadFireColorTexture(const std::string& path)
@@ -54,6 +64,7 @@ void FireLightsUpdater::loadFireColorTexture(const std::string& path)
         image_data4[i].z = image_data[i * 3 + 2];
         image_data4[i].w = 0.0f;
     }
+    buildFireColorLUT(image_data, image_shape[0]);
 
     cudaChannelFormatDesc formatDesc = cudaCreateChannelDesc<float4>();
     cudaMallocArray(&fire_color_array, &formatDesc, image_shape[0], 1);
@@ -85,17 +96,21 @@ __global__ void updateKernel(
     glm::ivec3 sample_dim,
     glm::ivec3 sample_avg_region,
     glm::ivec3 sample_kernel_size,
+    uint32_t phase,
+    uint32_t stride,
+    float smoothing,
     glm::vec3* out_intensities)
 {
-    auto tid = get_tid();
-
-    auto& out = out_intensities[tid];
-    int z = tid / (sample_dim.x * sample_dim.y);
-    int y = (tid % (sample_dim.x * sample_dim.y)) / sample_dim.x;
-    int x = tid % sample_dim.x;
-    if (x >= sample_dim.x || y >= sample_dim.y || z >= sample_dim.z) {
+    // only every stride-th cell, starting at phase, is resampled this time
+    auto cell = get_tid() * stride + phase;
+    if (cell >= sample_dim.x * sample_dim.y * sample_dim.z) {
         return;
     }
+
+    auto& out = out_intensities[cell];
+    int z = cell / (sample_dim.x * sample_dim.y);
+    int y = (cell % (sample_dim.x * sample_dim.y)) / sample_dim.x;
+    int x = cell % sample_dim.x;
     int3 image_xyz = make_int3(
         x * sample_kernel_size.x + sample_kernel_size.x / 2,
         y * sample_kernel_size.y + sample_kernel_size.y / 2,
@@ -119,42 +134,134 @@ __global__ void updateKernel(
     color /= (2 * sample_avg_region.x + 1)
         * (2 * sample_avg_region.y + 1)
         * (2 * sample_avg_region.z + 1) / light_sample_gain;
-    out = color;
+    out = glm::mix(out, glm::vec3(color), smoothing);
 }
 
-void FireLightsUpdater::updateFireLightData(cudaSurfaceObject_t fire_image, cudaStream_t streamToRun, Lights& lights)
+void FireLightsUpdater::launchKernel(cudaSurfaceObject_t fire_image, cudaStream_t streamToRun, const LightUpdate& update)
 {
-    dim3 thread_dim(
-        std::min(sample_dim.x, 4),
-        std::min(sample_dim.y, 4),
-        std::min(sample_dim.z, 4));
-    dim3 block_dim(
-        (sample_dim.x + 3) / 4,
-        (sample_dim.y + 3) / 4,
-        (sample_dim.z + 3) / 4);
-    updateKernel<<<block_dim, thread_dim, 0, streamToRun>>>(
+    const int threadsPerBlock = 64;
+    int cell_count = update.cellCount(sample_dim.x * sample_dim.y * sample_dim.z);
+    updateKernel<<<(cell_count + threadsPerBlock - 1) / threadsPerBlock, threadsPerBlock, 0, streamToRun>>>(
         fire_image,
         field_dim,
         fire_color_texture,
         sample_dim,
         sample_avg_region,
         sample_kernel_size,
+        update.phase,
+        update.stride,
+        update.smoothing,
         d_out_intensities);
+}
+
+void FireLightsUpdater::downloadIntensities()
+{
     cudaMemcpy(
         out_intensities.data(),
         d_out_intensities,
         sample_dim.x * sample_dim.y * sample_dim.z * sizeof(float3),
         cudaMemcpyDeviceToHost);
+}
 
-    for (int i = 0; i < sample_dim.x * sample_dim.y * sample_dim.z; i++) {
-        lights.data[i].intensity = out_intensities[i];
+void FireLightsUpdater::downloadAsync(cudaStream_t streamToRun, const LightUpdate& update)
+{
+    const uint32_t total = sample_dim.x * sample_dim.y * sample_dim.z;
+    const uint32_t cell_count = update.cellCount(total);
+    if (cell_count == 0)
+        return;
+
+    // every stride-th cell from phase on, at the same place on the host
+    const size_t pitch = update.stride * sizeof(glm::vec3);
+    cudaMemcpy2DAsync(
+        h_intensities + update.phase, pitch,
+        d_out_intensities + update.phase, pitch,
+        sizeof(glm::vec3), cell_count,
+        cudaMemcpyDeviceToHost,
+        streamToRun);
+    cudaEventRecord(download_done, streamToRun);
+    pending_update = update;
+    download_pending = true;
+}
+
+void FireLightsUpdater::applyDownload(Lights& lights)
+{
+    if (!download_pending)
+        return;
+    // recorded a frame ago, normally signaled already
+    cudaEventSynchronize(download_done);
+    download_pending = false;
+
+    const uint32_t total = sample_dim.x * sample_dim.y * sample_dim.z;
+    const uint32_t cell_count = pending_update.cellCount(total);
+    uint32_t cell = pending_update.phase;
+    for (uint32_t n = 0; n < cell_count; n++, cell += pending_update.stride) {
+        lights.data[cell].intensity = h_intensities[cell];
     }
-    lights.update(lights.data.data(), 0, lights.data.size());
+    const uint32_t first = pending_update.phase;
+    const uint32_t last = cell - pending_update.stride;
+    lights.update(lights.data.data() + first, first, last - first + 1);
+}
+
+void FireLightsUpdater::updateFireLightData(cudaSurfaceObject_t fire_image, cudaStream_t streamToRun, Lights& lights)
+{
+    applyDownload(lights);
+    auto update = nextUpdate();
+    launchKernel(fire_image, streamToRun, update);
+    downloadAsync(streamToRun, update);
+}
+
+double FireLightsUpdater::timeKernel(cudaSurfaceObject_t fire_image, cudaStream_t streamToRun, int iterations)
+{
+    cudaEvent_t start, stop;
+    cudaEventCreate(&start);
+    cudaEventCreate(&stop);
+
+    // warm up
+    launchKernel(fire_image, streamToRun, LightUpdate::full());
+    cudaEventRecord(start, streamToRun);
+    for (int i = 0; i < iterations; i++)
+        launchKernel(fire_image, streamToRun, LightUpdate::full());
+    cudaEventRecord(stop, streamToRun);
+    cudaEventSynchronize(stop);
+
+    float ms = 0.0f;
+    cudaEventElapsedTime(&ms, start, stop);
+    cudaEventDestroy(start);
+    cudaEventDestroy(stop);
+
+    downloadIntensities();
+    return ms / 1000.0;
+}
+
+__global__ void readFieldKernel(cudaSurfaceObject_t fire_image, glm::ivec3 dim, float* out)
+{
+    auto tid = get_tid();
+    if (tid >= dim.x * dim.y * dim.z)
+        return;
+    int z = tid / (dim.x * dim.y);
+    int y = (tid % (dim.x * dim.y)) / dim.x;
+    int x = tid % dim.x;
+    out[tid] = surf3Dread<float>(fire_image, x * sizeof(float), y, z);
+}
+
+void FireLightsUpdater::readbackField(cudaSurfaceObject_t fire_image, std::vector<float>& out)
+{
+    size_t count = field_dim.x * field_dim.y * field_dim.z;
+    out.resize(count);
+
+    float* d_field;
+    cudaMalloc(&d_field, count * sizeof(float));
+    const int threadsPerBlock = 256;
+    readFieldKernel<<<(count + threadsPerBlock - 1) / threadsPerBlock, threadsPerBlock>>>(fire_image, field_dim, d_field);
+    cudaMemcpy(out.data(), d_field, count * sizeof(float), cudaMemcpyDeviceToHost);
+    cudaFree(d_field);
 }
 
 void FireLightsUpdater::destroy()
 {
     cudaFreeArray(fire_color_array);
     cudaDestroyTextureObject(fire_color_texture);
-    cudaFree(&d_out_intensities);
+    cudaFree(d_out_intensities);
+    cudaFreeHost(h_intensities);
+    cudaEventDestroy(download_done);
 }
@@ -1,26 +1,81 @@
+#pragma once
+
 #include "core/config/config.h"
 #include "function/type/light.h"
 #include <glm/glm.hpp>
+#include <memory>
+#include <vector>
 
 struct FireLights;
+class ThreadPool;
 
 class FireLightsUpdater {
 public:
+    FireLightsUpdater();
+    ~FireLightsUpdater();
+
     void init(const FieldsConfiguration& config);
+    // Resamples the cells of this update and copies them back asynchronously,
+    // lights receives the cells resampled by the previous call
     void updateFireLightData(cudaSurfaceObject_t fire_image, cudaStream_t streamToRun, Lights& lights);
+    // CPU reference of updateFireLightData, temperature is laid out like the
+    // field image (x fastest) with field_dim voxels
+    void updateFireLightDataCPU(const float* temperature, Lights& lights);
+    // runs both paths on the same field and logs throughput and max error
+    void benchmark(cudaSurfaceObject_t fire_image, cudaStream_t streamToRun, int iterations);
     void destroy();
 
     glm::ivec3 sample_dim;
     glm::ivec3 sample_avg_region;
     glm::ivec3 sample_kernel_size;
     glm::ivec3 field_dim;
+    float sample_gain;
+
+    // cells are resampled every update_interval updates and blended into the
+    // previous intensity with factor smoothing
+    uint32_t update_interval;
+    float smoothing;
 
 private:
+    static constexpr int CPU_LUT_SIZE = 4096;
+
+    struct LightUpdate {
+        uint32_t phase;
+        uint32_t stride;
+        float smoothing;
+
+        static LightUpdate full() { return { 0, 1, 1.0f }; }
+        uint32_t cellCount(uint32_t total) const { return phase < total ? (total - phase + stride - 1) / stride : 0; }
+    };
+
+    LightUpdate nextUpdate();
+
     void loadFireColorTexture(const std::string& path);
+    void buildFireColorLUT(const std::vector<float>& colors, size_t color_count);
+    void computeCPU(const float* temperature, const LightUpdate& update, uint32_t begin, uint32_t end);
+    void launchKernel(cudaSurfaceObject_t fire_image, cudaStream_t streamToRun, const LightUpdate& update);
+    void downloadIntensities();
+    // copies the cells of update to h_intensities on streamToRun
+    void downloadAsync(cudaStream_t streamToRun, const LightUpdate& update);
+    // writes the cells of the pending download into lights
+    void applyDownload(Lights& lights);
+    double timeKernel(cudaSurfaceObject_t fire_image, cudaStream_t streamToRun, int iterations);
+    void readbackField(cudaSurfaceObject_t fire_image, std::vector<float>& out);
 
     cudaArray_t fire_color_array;
     cudaTextureObject_t fire_color_texture;
 
     glm::vec3* d_out_intensities;
     std::vector<glm::vec3> out_intensities;
+    // pinned, the cells of pending_update are valid once download_done signaled
+    glm::vec3* h_intensities;
+    cudaEvent_t download_done;
+    LightUpdate pending_update;
+    bool download_pending;
+    uint64_t update_count;
+
+    // fire colors resampled with the same filtering as fire_color_texture,
+    // split per channel so the accumulation loops vectorize
+    std::vector<float> lut_r, lut_g, lut_b;
+    std::unique_ptr<ThreadPool> cpu_pool;
 };
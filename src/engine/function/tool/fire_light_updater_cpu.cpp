@@ -0,0 +1,159 @@
+#include <cuda_runtime.h>
+
+#include "core/tool/logger.h"
+#include "core/tool/thread_pool.h"
+#include "fire_light_updater.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+FireLightsUpdater::FireLightsUpdater() = default;
+FireLightsUpdater::~FireLightsUpdater() = default;
+
+FireLightsUpdater::LightUpdate FireLightsUpdater::nextUpdate()
+{
+    // the first update fills every cell so smoothing starts from sampled values
+    LightUpdate update = update_count == 0
+        ? LightUpdate::full()
+        : LightUpdate { static_cast<uint32_t>(update_count % update_interval), update_interval, smoothing };
+    update_count++;
+    return update;
+}
+
+void FireLightsUpdater::buildFireColorLUT(const std::vector<float>& colors, size_t color_count)
+{
+    lut_r.resize(CPU_LUT_SIZE);
+    lut_g.resize(CPU_LUT_SIZE);
+    lut_b.resize(CPU_LUT_SIZE);
+
+    int last = static_cast<int>(color_count) - 1;
+    for (int i = 0; i < CPU_LUT_SIZE; i++) {
+        // tex1D with normalized coordinates, clamp addressing and linear filtering
+        float x = i / float(CPU_LUT_SIZE - 1) * color_count - 0.5f;
+        float x0 = std::floor(x);
+        float a = x - x0;
+        int i0 = std::clamp(static_cast<int>(x0), 0, last);
+        int i1 = std::clamp(static_cast<int>(x0) + 1, 0, last);
+        lut_r[i] = (1.0f - a) * colors[i0 * 3 + 0] + a * colors[i1 * 3 + 0];
+        lut_g[i] = (1.0f - a) * colors[i0 * 3 + 1] + a * colors[i1 * 3 + 1];
+        lut_b[i] = (1.0f - a) * colors[i0 * 3 + 2] + a * colors[i1 * 3 + 2];
+    }
+}
+
+void FireLightsUpdater::computeCPU(const float* temperature, const LightUpdate& update, uint32_t begin, uint32_t end)
+{
+    constexpr int LANES = 8;
+
+    const int row_length = 2 * sample_avg_region.x + 1;
+    const float lut_scale = float(CPU_LUT_SIZE - 1);
+    const float* lr = lut_r.data();
+    const float* lg = lut_g.data();
+    const float* lb = lut_b.data();
+
+    std::vector<int> xs(row_length);
+    std::vector<int> indices(row_length);
+
+    for (uint32_t n = begin; n < end; n++) {
+        uint32_t cell = n * update.stride + update.phase;
+        if (cell >= out_intensities.size())
+            break;
+        int z = cell / (sample_dim.x * sample_dim.y);
+        int y = (cell % (sample_dim.x * sample_dim.y)) / sample_dim.x;
+        int x = cell % sample_dim.x;
+        glm::ivec3 center = glm::ivec3(x, y, z) * sample_kernel_size + sample_kernel_size / 2;
+
+        for (int k = 0; k < row_length; k++)
+            xs[k] = std::clamp(center.x - sample_avg_region.x + k, 0, field_dim.x - 1);
+
+        glm::dvec3 color = glm::dvec3(0.0);
+        for (int i = center.z - sample_avg_region.z; i <= center.z + sample_avg_region.z; i++) {
+            int zc = std::clamp(i, 0, field_dim.z - 1);
+            for (int j = center.y - sample_avg_region.y; j <= center.y + sample_avg_region.y; j++) {
+                int yc = std::clamp(j, 0, field_dim.y - 1);
+                const float* line = temperature + (size_t(zc) * field_dim.y + yc) * field_dim.x;
+
+                for (int k = 0; k < row_length; k++)
+                    indices[k] = static_cast<int>(std::clamp(line[xs[k]], 0.0f, 1.0f) * lut_scale + 0.5f);
+
+                float r[LANES] = {}, g[LANES] = {}, b[LANES] = {};
+                int k = 0;
+                for (; k + LANES <= row_length; k += LANES) {
+                    for (int l = 0; l < LANES; l++) {
+                        r[l] += lr[indices[k + l]];
+                        g[l] += lg[indices[k + l]];
+                        b[l] += lb[indices[k + l]];
+                    }
+                }
+                for (; k < row_length; k++) {
+                    r[0] += lr[indices[k]];
+                    g[0] += lg[indices[k]];
+                    b[0] += lb[indices[k]];
+                }
+                for (int l = 0; l < LANES; l++)
+                    color += glm::dvec3(r[l], g[l], b[l]);
+            }
+        }
+        color /= (2 * sample_avg_region.x + 1)
+            * (2 * sample_avg_region.y + 1)
+            * (2 * sample_avg_region.z + 1) / sample_gain;
+        out_intensities[cell] = glm::mix(out_intensities[cell], glm::vec3(color), update.smoothing);
+    }
+}
+
+void FireLightsUpdater::updateFireLightDataCPU(const float* temperature, Lights& lights)
+{
+    if (!cpu_pool)
+        cpu_pool = std::make_unique<ThreadPool>();
+
+    LightUpdate update = nextUpdate();
+    uint32_t cell_count = update.cellCount(sample_dim.x * sample_dim.y * sample_dim.z);
+    cpu_pool->parallelFor(0, cell_count, [&](uint32_t begin, uint32_t end) {
+        computeCPU(temperature, update, begin, end);
+    });
+
+    for (int i = 0; i < sample_dim.x * sample_dim.y * sample_dim.z; i++) {
+        lights.data[i].intensity = out_intensities[i];
+    }
+    lights.update(lights.data.data(), 0, lights.data.size());
+}
+
+void FireLightsUpdater::benchmark(cudaSurfaceObject_t fire_image, cudaStream_t streamToRun, int iterations)
+{
+    if (iterations <= 0)
+        return;
+
+    std::vector<float> temperature;
+    readbackField(fire_image, temperature);
+
+    double cuda_seconds = timeKernel(fire_image, streamToRun, iterations);
+    std::vector<glm::vec3> cuda_intensities = out_intensities;
+
+    if (!cpu_pool)
+        cpu_pool = std::make_unique<ThreadPool>();
+    uint32_t cell_count = sample_dim.x * sample_dim.y * sample_dim.z;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        cpu_pool->parallelFor(0, cell_count, [&](uint32_t begin, uint32_t end) {
+            computeCPU(temperature.data(), LightUpdate::full(), begin, end);
+        });
+    }
+    double cpu_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    float max_error = 0.0f;
+    for (uint32_t i = 0; i < cell_count; i++) {
+        glm::vec3 diff = glm::abs(out_intensities[i] - cuda_intensities[i]);
+        max_error = std::max(max_error, std::max(diff.x, std::max(diff.y, diff.z)));
+    }
+
+    double voxels = double(cell_count)
+        * (2 * sample_avg_region.x + 1)
+        * (2 * sample_avg_region.y + 1)
+        * (2 * sample_avg_region.z + 1)
+        * iterations;
+    INFO_ALL("Fire light sampling benchmark: {} cells, {} iterations", cell_count, iterations);
+    INFO_ALL("    cuda: {:.3f} ms/update, {:.1f} Mvoxels/s",
+        cuda_seconds * 1000.0 / iterations, voxels / cuda_seconds / 1e6);
+    INFO_ALL("    cpu ({} threads): {:.3f} ms/update, {:.1f} Mvoxels/s",
+        cpu_pool->size() + 1, cpu_seconds * 1000.0 / iterations, voxels / cpu_seconds / 1e6);
+    INFO_ALL("    max abs difference: {}", max_error);
+}
@@ -14,7 +14,7 @@ using namespace Vk;
 
 void Camera::destroy()
 {
-    Buffer::Delete(g_ctx.vk, buffer);
+    PerFrameBuffer::Delete(g_ctx.vk, buffer);
 }
 
 void Camera::update_position(const glm::vec3& position)
@@ -22,21 +22,21 @@ void Camera::update_position(const glm::vec3& position)
     glm::vec3 center = position + data.view_dir;
     data.eye_w = position;
     data.view = glm::lookAt(position, center, data.up);
-    buffer.Update(g_ctx.vk, &data, sizeof(CameraData));
+    buffer.Update(&data, sizeof(CameraData));
 }
 
 void Camera::update_view_dir(const glm::vec3& view_dir)
 {
     data.view_dir = glm::normalize(view_dir);
     data.view = glm::lookAt(data.eye_w, data.eye_w + data.view_dir, data.up);
-    buffer.Update(g_ctx.vk, &data, sizeof(CameraData));
+    buffer.Update(&data, sizeof(CameraData));
 }
 
 void Camera::update_up(const glm::vec3& up)
 {
     data.view = glm::lookAt(data.eye_w, data.eye_w + data.view_dir, up);
     data.up = up;
-    buffer.Update(g_ctx.vk, &data, sizeof(CameraData));
+    buffer.Update(&data, sizeof(CameraData));
 }
 
 void Camera::update_fov(const float fov)
@@ -46,7 +46,7 @@ void Camera::update_fov(const float fov)
         0.1f, 100.0f);
     data.proj[1][1] *= -1;
     data.fov_y = fov;
-    buffer.Update(g_ctx.vk, &data, sizeof(CameraData));
+    buffer.Update(&data, sizeof(CameraData));
 }
 
 void Camera::update_aspect_ratio(const uint32_t width, const uint32_t height)
@@ -56,7 +56,7 @@ void Camera::update_aspect_ratio(const uint32_t width, const uint32_t height)
     data.aspect_ratio = width / (float)height;
     data.width = width;
     data.height = height;
-    buffer.Update(g_ctx.vk, &data, sizeof(CameraData));
+    buffer.Update(&data, sizeof(CameraData));
 }
 
 void Camera::update_rotation(const float dx, const float dy)
@@ -158,14 +158,10 @@ Camera Camera::fromConfiguration(CameraConfiguration& config)
         phi = -phi;
     camera.rotation = glm::degrees(glm::vec2(phi, theta));
 
-    camera.buffer = Vk::Buffer::New(
-        g_ctx.vk,
-        sizeof(CameraData),
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        true);
-    camera.buffer.Update(g_ctx.vk, &camera.data, sizeof(CameraData));
-    g_ctx.dm.registerResource(camera.buffer, DescriptorType::Uniform);
+    camera.buffer = Vk::PerFrameBuffer::New(g_ctx.vk, sizeof(CameraData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    camera.buffer.Update(&camera.data, sizeof(CameraData));
+    for (auto& buffer : camera.buffer.buffers)
+        g_ctx.dm.registerResource(buffer, DescriptorType::Uniform);
 
     return camera;
 }
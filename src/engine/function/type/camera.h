@@ -1,7 +1,7 @@
 #pragma once
 
 #include "core/config/config.h"
-#include "core/vulkan/type/buffer.h"
+#include "core/vulkan/type/per_frame_buffer.h"
 #include <glm/glm.hpp>
 #include <vulkan/vulkan.h>
 
@@ -25,7 +25,7 @@ struct Camera {
     glm::vec2 rotation;
     glm::vec3 init_view_dir;
 
-    Vk::Buffer buffer;
+    Vk::PerFrameBuffer buffer;
 
     void destroy();
     void update_position(const glm::vec3& position);
@@ -19,6 +19,7 @@ using cudaArray_t = unsigned long long*;
 using cudaTextureObject_t = unsigned long long*;
 using cudaSurfaceObject_t = unsigned long long*;
 using cudaStream_t = unsigned long long*;
+using cudaEvent_t = unsigned long long*;
 #include "function/tool/fire_light_updater.h"
 
 using namespace Vk;
@@ -31,7 +32,10 @@ Fields& Fields::operator=(Fields&& f) noexcept
     if (this != &f) {
         this->fields = std::move(f.fields);
         this->step = std::move(f.step);
-        this->paramBuffer = std::move(f.paramBuffer);
+        this->step_scale = std::move(f.step_scale);
+        this->params[0] = std::move(f.params[0]);
+        this->params[1] = std::move(f.params[1]);
+        this->double_buffered = std::move(f.double_buffered);
 
         this->has_temperature = std::move(f.has_temperature);
         this->lights_dim = std::move(f.lights_dim);
@@ -47,9 +51,11 @@ void Field::destroy()
 {
     Buffer::Delete(g_ctx.vk, attr_buf);
     Image::Delete(g_ctx.vk, field_img);
+    if (field_img_back.image != VK_NULL_HANDLE)
+        Image::Delete(g_ctx.vk, field_img_back);
 }
 
-void Field::init(const FieldConfiguration& cfg)
+void Field::init(const FieldConfiguration& cfg, bool double_buffered)
 {
     name = cfg.name;
 
@@ -62,11 +68,13 @@ void Field::init(const FieldConfiguration& cfg)
     attr_buf.Update(g_ctx.vk, &data, sizeof(FieldData));
     g_ctx.dm.registerResource(attr_buf, DescriptorType::Uniform);
 
-    initFieldImage(cfg);
+    initFieldImage(cfg, double_buffered);
     g_ctx.dm.registerResource(field_img, DescriptorType::CombinedImageSampler);
+    if (double_buffered)
+        g_ctx.dm.registerResource(field_img_back, DescriptorType::CombinedImageSampler);
 }
 
-void Field::initFieldImage(const FieldConfiguration& cfg)
+void Field::initFieldImage(const FieldConfiguration& cfg, bool double_buffered)
 {
     npy::npy_data d = npy::read_npy<float>(cfg.path);
     const auto& image_data = d.data;
@@ -78,21 +86,24 @@ void Field::initFieldImage(const FieldConfiguration& cfg)
         static_cast<uint32_t>(image_shape[1]),
         static_cast<uint32_t>(image_shape[2]),
     };
-    field_img = Image::New(
-        g_ctx.vk,
-        VK_FORMAT_R32_SFLOAT,
-        extent,
-        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        1,
-        true,
-        VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_TYPE_3D,
-        VK_IMAGE_VIEW_TYPE_3D);
-    field_img.Update(g_ctx.vk, image_data.data());
-    field_img.AddDefaultSampler(g_ctx.vk);
-    field_img.TransitionLayoutSingleTime(g_ctx.vk, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    for (uint32_t buffer = 0; buffer < (double_buffered ? 2 : 1); buffer++) {
+        auto& img = image(buffer);
+        img = Image::New(
+            g_ctx.vk,
+            VK_FORMAT_R32_SFLOAT,
+            extent,
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            1,
+            true,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_TYPE_3D,
+            VK_IMAGE_VIEW_TYPE_3D);
+        img.Update(g_ctx.vk, image_data.data());
+        img.AddDefaultSampler(g_ctx.vk);
+        img.TransitionLayoutSingleTime(g_ctx.vk, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
 }
 
 void SelfIlluminationLights::destroy()
@@ -113,13 +124,37 @@ void SelfIlluminationLights::init(const FieldsConfiguration& cfg)
     g_ctx.dm.registerResource(buffer, DescriptorType::Storage);
 }
 
+void Fields::setParameter(const std::string& field_name, const std::string& parameter, const std::vector<float>& value)
+{
+    if (parameter == "step") {
+        if (value.size() != 1)
+            throw std::runtime_error("step takes a single value");
+        step = value[0];
+        return;
+    }
+    if (parameter != "scatter" && parameter != "absorption")
+        throw std::runtime_error("unknown field parameter: " + parameter);
+    if (value.size() != 3)
+        throw std::runtime_error(parameter + " takes three values");
+
+    bool found = false;
+    for (auto& field : fields) {
+        if (!field_name.empty() && field.name != field_name)
+            continue;
+        found = true;
+        auto& target = parameter == "scatter" ? field.data.scatter : field.data.absorption;
+        target = glm::vec3(value[0], value[1], value[2]);
+        field.attr_buf.Update(g_ctx.vk, &field.data, sizeof(FieldData));
+    }
+    if (!found)
+        throw std::runtime_error("field not found: " + field_name);
+}
+
 void Fields::destroy()
 {
     for (auto& field : fields) {
         field.destroy();
     }
-    Buffer::Delete(g_ctx.vk, paramBuffer);
-
     if (has_temperature) {
         lights.destroy();
         lights_updater->destroy();
@@ -163,14 +198,10 @@ void Fields::initFireLights(const FieldsConfiguration& cfg)
             }
         }
     }
-    lights.buffer = Buffer::New(
-        g_ctx.vk,
-        total_num * sizeof(LightData),
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        true);
+    lights.buffer = PerFrameBuffer::New(g_ctx.vk, total_num * sizeof(LightData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
     lights.update(lights.data.data(), 0, total_num);
-    g_ctx.dm.registerResource(lights.buffer, DescriptorType::Storage);
+    for (auto& buffer : lights.buffer.buffers)
+        g_ctx.dm.registerResource(buffer, DescriptorType::Storage);
 }
 
 void Fields::initFireColorImage(const FieldsConfiguration& cfg)
@@ -202,11 +233,12 @@ void Fields::initFireColorImage(const FieldsConfiguration& cfg)
     g_ctx.dm.registerResource(fire_color_img, DescriptorType::CombinedImageSampler);
 }
 
-Fields Fields::fromConfiguration(const FieldsConfiguration& cfg)
+Fields Fields::fromConfiguration(const FieldsConfiguration& cfg, bool double_buffered)
 {
     Fields fields;
     fields.step = cfg.step;
     fields.has_temperature = false;
+    fields.double_buffered = double_buffered;
 
     assert(cfg.arr.size() <= MAX_FIELDS);
     int temp_field_cnt = 0;
@@ -229,7 +261,7 @@ Fields Fields::fromConfiguration(const FieldsConfiguration& cfg)
             fields.has_temperature = true;
         }
 
-        field.init(field_config);
+        field.init(field_config, double_buffered);
         fields.fields.emplace_back(field);
     }
 
@@ -246,20 +278,17 @@ Fields Fields::fromConfiguration(const FieldsConfiguration& cfg)
         fields.lights_updater->init(cfg);
     }
 
-    for (int i = 0; i < fields.fields.size(); i++) {
-        fields.param.attr[i * 4]
-            = g_ctx.dm.getResourceHandle(fields.fields[i].attr_buf.id);
-        fields.param.img[i * 4]
-            = g_ctx.dm.getResourceHandle(fields.fields[i].field_img.id);
+    for (uint32_t buffer = 0; buffer < (double_buffered ? 2 : 1); buffer++) {
+        auto& param = fields.params[buffer];
+        for (int i = 0; i < fields.fields.size(); i++) {
+            param.attr[i * 4]
+                = g_ctx.dm.getResourceHandle(fields.fields[i].attr_buf.descriptor);
+            param.img[i * 4]
+                = g_ctx.dm.getResourceHandle(fields.fields[i].image(buffer).descriptor);
+        }
     }
-    fields.paramBuffer = Buffer::New(
-        g_ctx.vk,
-        sizeof(Param),
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        true);
-    fields.paramBuffer.Update(g_ctx.vk, &fields.param, sizeof(Param));
-    g_ctx.dm.registerParameter(fields.paramBuffer);
+    if (!double_buffered)
+        fields.params[1] = fields.params[0];
 
     return fields;
 }
@@ -273,26 +302,26 @@ glm::mat4x4 Fields::toLocaluvw(const Camera& camera, const glm::vec3& start_pos,
 }
 
 #ifdef _WIN64
-HANDLE Fields::getVkFieldMemHandle(int index)
+HANDLE Fields::getVkFieldMemHandle(int index, uint32_t buffer)
 {
     HANDLE handle;
     VkMemoryGetWin32HandleInfoKHR vkMemoryGetWin32HandleInfoKHR = {};
     vkMemoryGetWin32HandleInfoKHR.sType = VK_STRUCTURE_TYPE_MEMORY_GET_WIN32_HANDLE_INFO_KHR;
-    vkMemoryGetWin32HandleInfoKHR.memory = field.field_img.memory;
+    vkMemoryGetWin32HandleInfoKHR.memory = fields[index].image(buffer).allocation.memory;
     vkMemoryGetWin32HandleInfoKHR.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_WIN32_BIT;
 
     fpGetMemoryWin32Handle(g_ctx.vk.device, &vkMemoryGetWin32HandleInfoKHR, &handle);
     return handle;
 }
 
-HANDLE Fields::getVkFieldMemHandle(const std::string& field_name)
+HANDLE Fields::getVkFieldMemHandle(const std::string& field_name, uint32_t buffer)
 {
     HANDLE handle;
     VkMemoryGetWin32HandleInfoKHR vkMemoryGetWin32HandleInfoKHR = {};
     vkMemoryGetWin32HandleInfoKHR.sType = VK_STRUCTURE_TYPE_MEMORY_GET_WIN32_HANDLE_INFO_KHR;
     for (const auto& field : fields) {
         if (field.name == field_name) {
-            vkMemoryGetWin32HandleInfoKHR.memory = field.field_img.memory;
+            vkMemoryGetWin32HandleInfoKHR.memory = field.image(buffer).allocation.memory;
             break;
         }
     }
@@ -302,26 +331,26 @@ HANDLE Fields::getVkFieldMemHandle(const std::string& field_name)
     return handle;
 }
 #else
-int Fields::getVkFieldMemHandle(int index)
+int Fields::getVkFieldMemHandle(int index, uint32_t buffer)
 {
     int fd;
     VkMemoryGetFdInfoKHR vkMemoryGetFdInfoKHR = {};
     vkMemoryGetFdInfoKHR.sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR;
-    vkMemoryGetFdInfoKHR.memory = fields[index].field_img.memory;
+    vkMemoryGetFdInfoKHR.memory = fields[index].image(buffer).allocation.memory;
     vkMemoryGetFdInfoKHR.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
 
     fpGetMemoryFdKHR(g_ctx.vk.device, &vkMemoryGetFdInfoKHR, &fd);
     return fd;
 }
 
-int Fields::getVkFieldMemHandle(const std::string& field_name)
+int Fields::getVkFieldMemHandle(const std::string& field_name, uint32_t buffer)
 {
     int fd;
     VkMemoryGetFdInfoKHR vkMemoryGetFdInfoKHR = {};
     vkMemoryGetFdInfoKHR.sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR;
     for (const auto& field : fields) {
         if (field.name == field_name) {
-            vkMemoryGetFdInfoKHR.memory = field.field_img.memory;
+            vkMemoryGetFdInfoKHR.memory = field.image(buffer).allocation.memory;
             break;
         }
     }
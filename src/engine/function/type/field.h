@@ -36,12 +36,17 @@ struct Field {
     Vk::Buffer attr_buf;
 
     Vk::Image field_img;
+    // second copy of field_img when fields are double buffered
+    Vk::Image field_img_back;
+
+    Vk::Image& image(uint32_t buffer) { return buffer == 0 ? field_img : field_img_back; }
+    const Vk::Image& image(uint32_t buffer) const { return buffer == 0 ? field_img : field_img_back; }
 
     void destroy();
-    void init(const FieldConfiguration& cfg);
+    void init(const FieldConfiguration& cfg, bool double_buffered);
 
 private:
-    void initFieldImage(const FieldConfiguration& cfg);
+    void initFieldImage(const FieldConfiguration& cfg, bool double_buffered);
 };
 
 class FireLightsUpdater;
@@ -70,9 +75,19 @@ struct Fields {
     Fields& operator=(Fields&&) noexcept;
 
     std::vector<Field> fields;
-    Param param;
-    Vk::Buffer paramBuffer;
+    // one parameter set per field image buffer, their handles never change
+    // so a frame in flight keeps sampling the buffer it was recorded with
+    Param params[2];
     float step;
+    // multiplies step when rendering, set by the frame budget
+    float step_scale = 1.0f;
+
+    // With double buffered fields, rendering frame n samples buffer n % 2 while
+    // the physics step of frame n writes buffer (n + 1) % 2, the one frame
+    // n + 1 renders. Otherwise both use buffer 0.
+    bool double_buffered;
+    uint32_t renderBuffer(uint32_t frame) const { return double_buffered ? frame % 2 : 0; }
+    uint32_t solverBuffer(uint32_t frame) const { return double_buffered ? (frame + 1) % 2 : 0; }
 
     // pipelines/render graph can use these
     bool has_temperature;
@@ -84,14 +99,19 @@ struct Fields {
 
     static glm::mat4x4 toLocaluvw(const Camera& camera, const glm::vec3& start_pos, const glm::vec3& size);
 
+    // Overrides step, or scatter/absorption of the named field (all fields if
+    // empty). The field attributes aren't per frame, only call it while the
+    // device is idle.
+    void setParameter(const std::string& field_name, const std::string& parameter, const std::vector<float>& value);
+
     void destroy();
-    static Fields fromConfiguration(const FieldsConfiguration& cfg);
+    static Fields fromConfiguration(const FieldsConfiguration& cfg, bool double_buffered);
 #ifdef _WIN64
-    HANDLE getVkFieldMemHandle(int index);
-    HANDLE getVkFieldMemHandle(const std::string& field_name);
+    HANDLE getVkFieldMemHandle(int index, uint32_t buffer = 0);
+    HANDLE getVkFieldMemHandle(const std::string& field_name, uint32_t buffer = 0);
 #else
-    int getVkFieldMemHandle(int index);
-    int getVkFieldMemHandle(const std::string& field_name);
+    int getVkFieldMemHandle(int index, uint32_t buffer = 0);
+    int getVkFieldMemHandle(const std::string& field_name, uint32_t buffer = 0);
 #endif
 
 private:
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "core/config/config.h"
-#include "core/vulkan/type/buffer.h"
+#include "core/vulkan/type/per_frame_buffer.h"
 #include <glm/glm.hpp>
 #include <vulkan/vulkan.h>
 
@@ -16,7 +16,7 @@ struct Lights {
     std::string name;
 
     std::vector<LightData> data;
-    Vk::Buffer buffer;
+    Vk::PerFrameBuffer buffer;
 
     void update(const LightData* data, int index, int cnt);
     void destroy();
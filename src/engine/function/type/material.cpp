@@ -7,13 +7,13 @@ using namespace Vk;
 
 void Material::destroy()
 {
-    Buffer::Delete(g_ctx.vk, buffer);
+    PerFrameBuffer::Delete(g_ctx.vk, buffer);
 }
 
 void Material::update(const MaterialData& data)
 {
     this->data = data;
-    buffer.Update(g_ctx.vk, &this->data, sizeof(data));
+    buffer.Update(&this->data, sizeof(data));
 }
 
 Material Material::fromConfiguration(const MaterialConfiguration& config)
@@ -25,24 +25,20 @@ Material Material::fromConfiguration(const MaterialConfiguration& config)
     material.data.metallic = config.metallic;
     material.data.color = arrayToVec3(config.color);
     material.data.color_texture = g_ctx.dm.getResourceHandle(
-        g_ctx.rm->textures[config.color_texture].image.id);
+        g_ctx.rm->textures[config.color_texture].image.descriptor);
     material.data.metallic_texture = g_ctx.dm.getResourceHandle(
-        g_ctx.rm->textures[config.metallic_texture].image.id);
+        g_ctx.rm->textures[config.metallic_texture].image.descriptor);
     material.data.roughness_texture = g_ctx.dm.getResourceHandle(
-        g_ctx.rm->textures[config.roughness_texture].image.id);
+        g_ctx.rm->textures[config.roughness_texture].image.descriptor);
     material.data.normal_texture = g_ctx.dm.getResourceHandle(
-        g_ctx.rm->textures[config.normal_texture].image.id);
+        g_ctx.rm->textures[config.normal_texture].image.descriptor);
     material.data.ao_texture = g_ctx.dm.getResourceHandle(
-        g_ctx.rm->textures[config.ao_texture].image.id);
+        g_ctx.rm->textures[config.ao_texture].image.descriptor);
 
-    material.buffer = Buffer::New(
-        g_ctx.vk,
-        sizeof(material.data),
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        true);
-    material.buffer.Update(g_ctx.vk, &material.data, sizeof(material.data));
-    g_ctx.dm.registerResource(material.buffer, DescriptorType::Uniform);
+    material.buffer = PerFrameBuffer::New(g_ctx.vk, sizeof(material.data), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    material.buffer.Update(&material.data, sizeof(material.data));
+    for (auto& buffer : material.buffer.buffers)
+        g_ctx.dm.registerResource(buffer, DescriptorType::Uniform);
 
     return material;
 }
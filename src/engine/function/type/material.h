@@ -2,7 +2,7 @@
 
 #include "core/config/config.h"
 #include "core/vulkan/descriptor_manager.h"
-#include "core/vulkan/type/buffer.h"
+#include "core/vulkan/type/per_frame_buffer.h"
 #include <glm/glm.hpp>
 #include <vulkan/vulkan.h>
 
@@ -21,7 +21,7 @@ struct Material {
     std::string name;
 
     MaterialData data;
-    Vk::Buffer buffer;
+    Vk::PerFrameBuffer buffer;
 
     void update(const MaterialData& data);
     void destroy();
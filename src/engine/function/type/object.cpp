@@ -7,7 +7,7 @@ using namespace Vk;
 
 void Object::destroy()
 {
-    Buffer::Delete(g_ctx.vk, paramBuffer);
+    params.clear();
 }
 
 Object Object::fromConfiguration(ObjectConfiguration& config)
@@ -17,15 +17,10 @@ Object Object::fromConfiguration(ObjectConfiguration& config)
     obj.uuid = uuid::newUUID();
     obj.mesh = config.mesh;
 
-    obj.param.material = g_ctx.dm.getResourceHandle(g_ctx.rm->materials[config.material].buffer.id);
-    obj.paramBuffer = Buffer::New(
-        g_ctx.vk,
-        sizeof(Param),
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        true);
-    obj.paramBuffer.Update(g_ctx.vk, &obj.param, sizeof(Param));
-    g_ctx.dm.registerParameter(obj.paramBuffer);
+    const auto& material = g_ctx.rm->materials[config.material];
+    obj.params.resize(g_ctx.vk.framesInFlight);
+    for (uint32_t slot = 0; slot < obj.params.size(); slot++)
+        obj.params[slot].material = g_ctx.dm.getResourceHandle(material.buffer[slot].descriptor);
 
     return obj;
 }
@@ -36,7 +31,7 @@ HANDLE Object::getVkVertexMemHandle()
     HANDLE handle;
     VkMemoryGetWin32HandleInfoKHR vkMemoryGetWin32HandleInfoKHR = {};
     vkMemoryGetWin32HandleInfoKHR.sType = VK_STRUCTURE_TYPE_MEMORY_GET_WIN32_HANDLE_INFO_KHR;
-    vkMemoryGetFdInfoKHR.memory = g_ctx.rm->meshes[mesh].vertexBuffer.memory;
+    vkMemoryGetFdInfoKHR.memory = g_ctx.rm->meshes[mesh].vertexBuffer.allocation.memory;
     vkMemoryGetWin32HandleInfoKHR.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_WIN32_BIT;
 
     fpGetMemoryWin32Handle(g_ctx.vk.device, &vkMemoryGetWin32HandleInfoKHR, &handle);
@@ -48,7 +43,7 @@ int Object::getVkVertexMemHandle()
     int fd;
     VkMemoryGetFdInfoKHR vkMemoryGetFdInfoKHR = {};
     vkMemoryGetFdInfoKHR.sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR;
-    vkMemoryGetFdInfoKHR.memory = g_ctx.rm->meshes[mesh].vertexBuffer.memory;
+    vkMemoryGetFdInfoKHR.memory = g_ctx.rm->meshes[mesh].vertexBuffer.allocation.memory;
     vkMemoryGetFdInfoKHR.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
 
     fpGetMemoryFdKHR(g_ctx.vk.device, &vkMemoryGetFdInfoKHR, &fd);
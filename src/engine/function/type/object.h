@@ -17,8 +17,8 @@ struct Object {
     uuid::UUID uuid;
 
     std::string mesh;
-    Param param;
-    Vk::Buffer paramBuffer;
+    // one per frame in flight, each pointing at that frame's material copy
+    std::vector<Param> params;
 
 #ifdef _WIN64
     HANDLE getVkVertexMemHandle();
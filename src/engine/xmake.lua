@@ -47,6 +47,7 @@ target("engine")
         add_cxxflags("-DDEBUG")
     elseif is_mode("release") then
         add_cxxflags("-DNDEBUG")
+        add_defines("SPDLOG_ACTIVE_LEVEL=SPDLOG_LEVEL_DEBUG", {public = true})
     end
     before_build(function (target)
         os.mkdir("$(buildir)/shaders")
@@ -55,7 +56,8 @@ target("engine")
         os.cp("$(scriptdir)/function/render/render_graph/shader/*.glsl", "$(buildir)/shaders")
     end)
 
-local function shader_target(name)
+local function shader_target(name, stages)
+stages = stages or {"vert", "frag"}
 target(name.. "_shader")
     set_kind("static")
     add_rules("utils.glsl2spv",
@@ -64,8 +66,9 @@ target(name.. "_shader")
             debugsource = is_mode("debug")
         })
     add_packages("glslc")
-    add_files("**/node/"..name.."/*.vert")
-    add_files("**/node/"..name.."/*.frag")
+    for _, stage in ipairs(stages) do
+        add_files("**/node/"..name.."/*."..stage)
+    end
     after_build(function (target)
         if not is_mode("release") then
             return
@@ -89,3 +92,4 @@ shader_target("default_object")
 shader_target("fire_object")
 shader_target("field")
 shader_target("hdr_to_sdr")
+shader_target("record_yuv", {"comp"})
@@ -0,0 +1,74 @@
+#include "config.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+int failures = 0;
+
+#define CHECK(condition)                                                \
+    do {                                                                \
+        if (!(condition)) {                                             \
+            std::fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                 \
+        }                                                               \
+    } while (false)
+
+std::string writeFile(const std::string& name, const std::string& content)
+{
+    auto path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream(path) << content;
+    return path;
+}
+
+void minimalBatch()
+{
+    auto path = writeFile("minimal_batch.json", R"({ "frames": 24, "output_path": "out/run_{}.mp4" })");
+    auto batch = BatchConfiguration::load(path);
+    CHECK(batch.frames == 24);
+    CHECK(batch.output_path == "out/run_{}.mp4");
+    CHECK(batch.camera_path.empty());
+    CHECK(batch.sweep.values.empty());
+    std::filesystem::remove(path);
+}
+
+void sweepWithoutField()
+{
+    auto path = writeFile("sweep_batch.json", R"({
+        "frames": 1,
+        "output_path": "out.mp4",
+        "sweep": { "parameter": "step", "values": [[0.5], [1.0]] }
+    })");
+    auto batch = BatchConfiguration::load(path);
+    CHECK(batch.sweep.field.empty());
+    CHECK(batch.sweep.parameter == "step");
+    CHECK(batch.sweep.values.size() == 2);
+    std::filesystem::remove(path);
+}
+
+void batchWithoutFrames()
+{
+    auto path = writeFile("empty_batch.json", "{}");
+    bool thrown = false;
+    try {
+        BatchConfiguration::load(path);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    std::filesystem::remove(path);
+}
+}
+
+int main()
+{
+    minimalBatch();
+    sweepWithoutField();
+    batchWithoutFrames();
+    if (failures > 0) {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,11 @@
+add_rules("mode.release", "mode.debug")
+
+includes("./../engine/core/config/xmake.lua")
+
+target("config_test")
+    set_kind("binary")
+    set_languages("cxx20")
+    set_default(false)
+    add_files("config_test.cpp")
+    add_deps("config")
+    add_tests("default")